@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace nsc::bench {
+
+// Keeps the optimizer from dropping a value that is computed only to be
+// timed.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct result {
+    std::string name;
+    std::size_t n;
+    std::size_t ops;
+    double total_ns;
+};
+
+struct options {
+    // Container sizes to run, smallest first.
+    std::vector<std::size_t> sizes;
+    int repeats = 5;
+    bool quick = false;
+    // Where the JSON goes; stdout if empty.
+    std::string out;
+};
+
+// --quick stops at 1e5 entries and runs each case once, which is enough to
+// check that every case still runs. --out <path> writes the JSON to a file.
+inline options parse_options(int argc, char** argv) {
+    options opts;
+    std::size_t max_n = 10'000'000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            max_n = 100'000;
+            opts.repeats = 1;
+            opts.quick = true;
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            opts.out = argv[++i];
+        }
+    }
+    for (std::size_t n = 1'000; n <= max_n; n *= 10) {
+        opts.sizes.push_back(n);
+    }
+    return opts;
+}
+
+class reporter {
+   public:
+    explicit reporter(const options& opts) : opts_(opts) {}
+
+    // Runs f repeats times and keeps the fastest. f does its own setup and
+    // returns the nanoseconds spent on the ops operations being measured.
+    template <typename F>
+    void run(const char* name, std::size_t n, std::size_t ops, F&& f) {
+        double best = 0.0;
+        for (int i = 0; i < opts_.repeats; ++i) {
+            double ns = f();
+            best = i == 0 ? ns : std::min(best, ns);
+        }
+        results_.push_back(result{name, n, ops, best});
+        std::fprintf(stderr, "%-40s n=%-9zu %9.2f ns/op\n", name, n, best / static_cast<double>(ops ? ops : 1));
+    }
+
+    // Returns false if the output file could not be written.
+    bool write_json() const {
+        auto file = opts_.out.empty() ? stdout : std::fopen(opts_.out.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+        std::fprintf(file, "{\n  \"benchmarks\": [\n");
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const auto& r = results_[i];
+            std::fprintf(file,
+                         "    {\"name\": \"%s\", \"n\": %zu, \"ops\": %zu, \"total_ns\": %.0f, \"ns_per_op\": %.3f}%s\n",
+                         r.name.c_str(), r.n, r.ops, r.total_ns, r.total_ns / static_cast<double>(r.ops ? r.ops : 1),
+                         i + 1 < results_.size() ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        if (file != stdout) {
+            std::fclose(file);
+        }
+        return true;
+    }
+
+   private:
+    options opts_;
+    std::vector<result> results_;
+};
+
+// Times f once.
+template <typename F>
+double time_ns(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+}  // namespace nsc::bench
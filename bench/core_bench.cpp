@@ -0,0 +1,239 @@
+// Times the core containers at 1e3 to 1e7 entries and writes the results
+// as JSON. See bench.hpp for the flags.
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "bench.hpp"
+#include "framework/core/event_handler.hpp"
+#include "framework/core/registry.hpp"
+#include "framework/rendering/renderer_registry.hpp"
+
+namespace {
+
+using nsc::bench::do_not_optimize;
+using nsc::bench::reporter;
+using nsc::bench::time_ns;
+
+struct position {
+    float x, y, z;
+};
+
+struct tick {
+    std::uint64_t frame;
+};
+
+// Event subscriptions are about 70 bytes each, so they stop at 1e6.
+constexpr std::size_t max_subscribers = 1'000'000;
+
+std::vector<nsc::obj_handle> fill(nsc::registry& reg, std::size_t n) {
+    std::vector<nsc::obj_handle> handles;
+    handles.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        handles.push_back(reg.create<position>(static_cast<float>(i), 0.0f, 0.0f));
+    }
+    return handles;
+}
+
+float sum_group(const nsc::registry& reg) {
+    float sum = 0.0f;
+    if (auto group = reg.get_group<position>(); group) {
+        for (const auto& p : *group) {
+            sum += p.x;
+        }
+    }
+    return sum;
+}
+
+void bench_registry(reporter& report, std::size_t n) {
+    std::mt19937 rng(42);
+
+    report.run("registry/create", n, n, [&] {
+        nsc::registry reg;
+        return time_ns([&] { do_not_optimize(fill(reg, n)); });
+    });
+
+    report.run("registry/get_shuffled", n, n, [&] {
+        nsc::registry reg;
+        auto handles = fill(reg, n);
+        std::shuffle(handles.begin(), handles.end(), rng);
+        return time_ns([&] {
+            float sum = 0.0f;
+            for (auto handle : handles) {
+                sum += reg.get<position>(handle)->x;
+            }
+            do_not_optimize(sum);
+        });
+    });
+
+    report.run("registry/iterate", n, n, [&] {
+        nsc::registry reg;
+        fill(reg, n);
+        return time_ns([&] { do_not_optimize(sum_group(reg)); });
+    });
+
+    report.run("registry/remove_shuffled", n, n, [&] {
+        nsc::registry reg;
+        auto handles = fill(reg, n);
+        std::shuffle(handles.begin(), handles.end(), rng);
+        return time_ns([&] {
+            for (auto handle : handles) {
+                reg.remove<position>(handle);
+            }
+        });
+    });
+
+    // The pattern that used to leave tombstones behind: half the entries
+    // removed at random, then the rest iterated.
+    report.run("registry/churn_remove_half", n, n / 2, [&] {
+        nsc::registry reg;
+        auto handles = fill(reg, n);
+        std::shuffle(handles.begin(), handles.end(), rng);
+        return time_ns([&] {
+            for (std::size_t i = 0; i < n / 2; ++i) {
+                reg.remove<position>(handles[i]);
+            }
+        });
+    });
+
+    report.run("registry/churn_iterate", n, n - n / 2, [&] {
+        nsc::registry reg;
+        auto handles = fill(reg, n);
+        std::shuffle(handles.begin(), handles.end(), rng);
+        for (std::size_t i = 0; i < n / 2; ++i) {
+            reg.remove<position>(handles[i]);
+        }
+        return time_ns([&] { do_not_optimize(sum_group(reg)); });
+    });
+}
+
+void bench_events(reporter& report, std::size_t n) {
+    if (n > max_subscribers) {
+        return;
+    }
+    std::mt19937 rng(42);
+    std::uint64_t total = 0;
+
+    auto subscribe_all = [&](nsc::event_handler& handler) {
+        std::vector<nsc::event_handle> handles;
+        handles.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            handles.push_back(handler.subscribe<tick>([&total](const tick& t) { total += t.frame; }));
+        }
+        return handles;
+    };
+
+    report.run("event_handler/subscribe", n, n, [&] {
+        nsc::event_handler handler;
+        return time_ns([&] { do_not_optimize(subscribe_all(handler)); });
+    });
+
+    // Enough publishes for about 1e7 callbacks, so small lists are not
+    // timed on a single call.
+    auto publishes = std::max<std::size_t>(1, 10'000'000 / n);
+    report.run("event_handler/publish", n, publishes * n, [&] {
+        nsc::event_handler handler;
+        subscribe_all(handler);
+        return time_ns([&] {
+            for (std::size_t i = 0; i < publishes; ++i) {
+                handler.publish(tick{i});
+            }
+        });
+    });
+
+    report.run("event_handler/unsubscribe_shuffled", n, n, [&] {
+        nsc::event_handler handler;
+        auto handles = subscribe_all(handler);
+        std::shuffle(handles.begin(), handles.end(), rng);
+        return time_ns([&] {
+            for (auto handle : handles) {
+                handler.unsubscribe<tick>(handle);
+            }
+        });
+    });
+    do_not_optimize(total);
+}
+
+// Four small renderable types, as a scene of mixed widgets would have.
+template <int Kind>
+struct widget {
+    float x, y;
+    void render(std::uint64_t& out) { out += static_cast<std::uint64_t>(x + y) + Kind; }
+};
+
+template <typename Emplace>
+void fill_renderers(std::size_t n, Emplace&& emplace) {
+    for (std::size_t i = 0; i < n; ++i) {
+        auto x = static_cast<float>(i);
+        switch (i % 4) {
+            case 0: emplace(widget<0>{x, 1.0f}); break;
+            case 1: emplace(widget<1>{x, 2.0f}); break;
+            case 2: emplace(widget<2>{x, 3.0f}); break;
+            default: emplace(widget<3>{x, 4.0f}); break;
+        }
+    }
+}
+
+void bench_renderers(reporter& report, std::size_t n) {
+    report.run("renderer_registry/render", n, n, [&] {
+        nsc::rendering::renderer_registry<std::uint64_t&> renderers;
+        fill_renderers(n, [&](auto w) { renderers.emplace(w); });
+        std::uint64_t out = 0;
+        auto ns = time_ns([&] { renderers.render(out); });
+        do_not_optimize(out);
+        return ns;
+    });
+
+    report.run("renderer_registry/render_erased", n, n, [&] {
+        nsc::rendering::renderer_registry<std::uint64_t&> renderers;
+        fill_renderers(n, [&](auto w) { renderers.emplace_erased(w); });
+        std::uint64_t out = 0;
+        auto ns = time_ns([&] { renderers.render(out); });
+        do_not_optimize(out);
+        return ns;
+    });
+}
+
+// Tiny chunks, so the time is the pool's own cost per task: pushing,
+// popping or stealing it, and waking workers. The callable is a const
+// lvalue, which parallel_for has to accept.
+void bench_thread_pool(reporter& report, std::size_t n) {
+    constexpr std::size_t grain = 64;
+    nsc::thread_pool pool(std::max<std::size_t>(nsc::thread_pool::default_worker_count(), 1));
+    std::vector<float> values(n, 1.0f);
+    std::vector<float> sums((n + grain - 1) / grain);
+
+    report.run("thread_pool/parallel_for_chunk", n, sums.size(), [&] {
+        const auto body = [&](std::size_t begin, std::size_t end) {
+            sums[begin / grain] = std::accumulate(values.begin() + begin, values.begin() + end, 0.0f);
+        };
+        auto ns = time_ns([&] { pool.parallel_for(n, grain, body); });
+        do_not_optimize(sums);
+        return ns;
+    });
+
+    report.run("registry/parallel_iterate", n, n, [&] {
+        nsc::registry reg;
+        fill(reg, n);
+        return time_ns([&] {
+            reg.parallel_view<position>(pool, [](nsc::obj_handle, position& p) { p.y += p.x; });
+        });
+    });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    auto opts = nsc::bench::parse_options(argc, argv);
+    reporter report(opts);
+    for (auto n : opts.sizes) {
+        bench_registry(report, n);
+        bench_events(report, n);
+        bench_renderers(report, n);
+        bench_thread_pool(report, n);
+    }
+    return report.write_json() ? 0 : 1;
+}
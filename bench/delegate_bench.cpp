@@ -0,0 +1,130 @@
+// Compares element event handlers, which keep callbacks in an
+// inplace_function, with a list of std::function as the handlers used to
+// keep them, for 1, 16 and 256 handlers. Subscribing is timed on the
+// per-event registry alone, so that creating elements is left out. Writes
+// the results as JSON; see bench.hpp for the flags.
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "bench.hpp"
+#include "framework/ui/element.hpp"
+#include "framework/ui/events.hpp"
+
+namespace {
+
+using nsc::bench::do_not_optimize;
+using nsc::bench::reporter;
+using nsc::bench::time_ns;
+
+// What event_callback_registry stored before inplace_function.
+using function_list = std::vector<std::pair<nsc::event_handle, std::function<void(const MouseClickEvent &)>>>;
+
+// A reference, an int and two doubles: a typical handler's captures, and
+// past std::function's inline buffer.
+#define CLICK_HANDLER(sum, i) [&sum, i, a = 1.0, b = 2.0](const MouseClickEvent &e) { sum += e.element_id ^ i; }
+
+void bench_subscribe(reporter &report, std::size_t handlers, std::size_t total) {
+    auto lists = std::max<std::size_t>(1, total / handlers);
+    std::uint64_t sum = 0;
+
+    report.run("delegate/subscribe_inplace", handlers, lists * handlers, [&] {
+        std::vector<nsc::event_callback_registry<MouseClickEvent>> elements(lists);
+        return time_ns([&] {
+            for (auto &element : elements) {
+                for (std::uint32_t i = 0; i < handlers; ++i) {
+                    element.subscribe(CLICK_HANDLER(sum, i));
+                }
+            }
+        });
+    });
+
+    report.run("delegate/subscribe_std_function", handlers, lists * handlers, [&] {
+        std::vector<function_list> elements(lists);
+        nsc::event_handle next = 0;
+        return time_ns([&] {
+            for (auto &element : elements) {
+                for (std::uint32_t i = 0; i < handlers; ++i) {
+                    element.emplace_back(next++, CLICK_HANDLER(sum, i));
+                }
+            }
+        });
+    });
+    do_not_optimize(sum);
+}
+
+void bench_publish(reporter &report, std::size_t handlers, std::size_t total) {
+    auto publishes = std::max<std::size_t>(1, total / handlers);
+    std::uint64_t sum = 0;
+
+    report.run("delegate/publish_inplace", handlers, publishes * handlers, [&] {
+        nsc::ui::Element element(0, nsc::ui::Rectangle());
+        for (std::uint32_t i = 0; i < handlers; ++i) {
+            element.subscribe_on<MouseClickEvent>(CLICK_HANDLER(sum, i));
+        }
+        return time_ns([&] {
+            for (std::size_t i = 0; i < publishes; ++i) {
+                element.publish_on(MouseClickEvent{static_cast<std::uint32_t>(i), 0.0f, 0.0f});
+            }
+        });
+    });
+
+    report.run("delegate/publish_std_function", handlers, publishes * handlers, [&] {
+        function_list element;
+        for (std::uint32_t i = 0; i < handlers; ++i) {
+            element.emplace_back(i, CLICK_HANDLER(sum, i));
+        }
+        return time_ns([&] {
+            for (std::size_t i = 0; i < publishes; ++i) {
+                MouseClickEvent e{static_cast<std::uint32_t>(i), 0.0f, 0.0f};
+                for (auto &callback : element) {
+                    if (callback.second) {
+                        callback.second(e);
+                    }
+                }
+            }
+        });
+    });
+    do_not_optimize(sum);
+}
+
+// Wrapping a handler and calling it once, as a one-shot subscription does.
+void bench_construct_call(reporter &report, std::size_t total) {
+    std::uint64_t sum = 0;
+
+    report.run("delegate/construct_call_inplace", 1, total, [&] {
+        return time_ns([&] {
+            for (std::uint32_t i = 0; i < total; ++i) {
+                nsc::inplace_function<void(const MouseClickEvent &)> callback = CLICK_HANDLER(sum, i);
+                callback(MouseClickEvent{i, 0.0f, 0.0f});
+            }
+        });
+    });
+
+    report.run("delegate/construct_call_std_function", 1, total, [&] {
+        return time_ns([&] {
+            for (std::uint32_t i = 0; i < total; ++i) {
+                std::function<void(const MouseClickEvent &)> callback = CLICK_HANDLER(sum, i);
+                callback(MouseClickEvent{i, 0.0f, 0.0f});
+            }
+        });
+    });
+    do_not_optimize(sum);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    auto opts = nsc::bench::parse_options(argc, argv);
+    reporter report(opts);
+    std::size_t subscribes = opts.quick ? 10'000 : 1'000'000;
+    std::size_t calls = opts.quick ? 100'000 : 10'000'000;
+    for (std::size_t handlers : {1, 16, 256}) {
+        bench_subscribe(report, handlers, subscribes);
+        bench_publish(report, handlers, calls);
+    }
+    bench_construct_call(report, subscribes);
+    return report.write_json() ? 0 : 1;
+}
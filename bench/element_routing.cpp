@@ -0,0 +1,116 @@
+// Callbacks that delete or release elements on the route of the event they
+// are handling. Fails if the route goes on past the change or reaches a
+// deleted element; run under AddressSanitizer to also catch reads of freed
+// routes and handlers.
+
+#include <cstdio>
+
+#include "framework/ui/element.hpp"
+
+namespace {
+
+struct click {};
+
+int destroyed = 0;
+
+struct counted : nsc::ui::Element {
+    counted(uint32_t id) : Element(id, nsc::ui::Rectangle(0, 0, 100, 100)) {}
+    ~counted() override { ++destroyed; }
+};
+
+struct tree {
+    counted *root = new counted(0);
+    counted *mid = new counted(1);
+    counted *target = new counted(2);
+    int calls = 0;
+
+    tree() {
+        root->add_child(mid);
+        mid->add_child(target);
+        for (nsc::ui::Element *e : {(nsc::ui::Element *)root, (nsc::ui::Element *)mid, (nsc::ui::Element *)target}) {
+            e->subscribe_capture_on<click>([this](const click &) { ++calls; });
+            e->subscribe_on<click>([this](const click &) { ++calls; });
+        }
+    }
+
+    ~tree() {
+        nsc::ui::Element::delete_released();
+        delete target;
+        delete mid;
+        delete root;
+    }
+};
+
+bool check(const char *name, bool ok) {
+    std::printf("%s: %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// The target is not dispatching, so a plain delete is fine; the route must
+// end without reading the target's route again.
+bool run_capture_deletes_target() {
+    tree t;
+    destroyed = 0;
+    t.root->subscribe_capture_on<click>([&t](const click &) {
+        delete t.target;
+        t.target = nullptr;
+    });
+    t.target->route_event(click{});
+    return check("capture deletes target", t.calls == 1 && destroyed == 1);
+}
+
+bool run_target_releases_itself() {
+    tree t;
+    destroyed = 0;
+    t.target->subscribe_on<click>([&t](const click &) { nsc::ui::Element::release(t.target); });
+    t.target->route_event(click{});
+    bool ok = t.calls == 3 && destroyed == 0 && t.target->get_parent() == nullptr;
+    nsc::ui::Element::delete_released();
+    t.target = nullptr;
+    return check("target releases itself", ok && destroyed == 1);
+}
+
+bool run_capture_releases_itself() {
+    tree t;
+    destroyed = 0;
+    t.mid->subscribe_capture_on<click>([&t](const click &) {
+        nsc::ui::Element::release(t.mid);
+        nsc::ui::Element::release(t.mid);
+    });
+    t.target->route_event(click{});
+    bool ok = t.calls == 2 && destroyed == 0 && t.mid->get_parent() == nullptr;
+    nsc::ui::Element::delete_released();
+    t.mid = nullptr;
+    return check("capture releases itself", ok && destroyed == 1 && t.target->get_parent() == nullptr);
+}
+
+bool run_root_releases_itself() {
+    tree t;
+    destroyed = 0;
+    t.root->subscribe_on<click>([&t](const click &) { nsc::ui::Element::release(t.root); });
+    bool nested = false;
+    t.mid->subscribe_on<click>([&t, &nested](const click &) {
+        if (!nested) {
+            nested = true;
+            t.target->route_event(click{});
+        }
+    });
+    t.target->route_event(click{});
+    // Captures run on ancestors only. The outer route reaches mid's bubble
+    // (4 calls), routes again all the way up to root's release (5 more), and
+    // then must not go on to root.
+    bool ok = t.calls == 9 && destroyed == 0;
+    nsc::ui::Element::delete_released();
+    t.root = nullptr;
+    return check("root releases itself", ok && destroyed == 1 && t.mid->get_parent() == nullptr);
+}
+
+}  // namespace
+
+int main() {
+    bool ok = run_capture_deletes_target();
+    ok = run_target_releases_itself() && ok;
+    ok = run_capture_releases_itself() && ok;
+    ok = run_root_releases_itself() && ok;
+    return ok ? 0 : 1;
+}
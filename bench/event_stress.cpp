@@ -0,0 +1,106 @@
+// Thousands of callbacks that subscribe, unsubscribe themselves and each
+// other, and publish again while an event is being dispatched. Fails if a
+// callback runs after it was unsubscribed or its captures were destroyed
+// while it ran, or if publishing with no subscription changes allocates.
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "framework/core/event_handler.hpp"
+#include "framework/core/memory.hpp"
+
+namespace {
+
+struct ping {
+    int depth;
+};
+
+struct stress {
+    nsc::event_handler handler;
+    std::mt19937 rng{7};
+    std::vector<nsc::event_handle> live;
+    std::unordered_set<nsc::event_handle> alive;
+    long calls = 0;
+    long errors = 0;
+
+    void subscribe() {
+        // Destroying the callback resets the token, so a callback freed
+        // while it runs sees it change.
+        auto token = std::make_shared<int>(1);
+        auto self = std::make_shared<nsc::event_handle>();
+        *self = handler.subscribe<ping>([this, token, self](const ping& e) {
+            ++calls;
+            if (!alive.count(*self) || *token != 1) {
+                ++errors;
+            }
+            switch (rng() % 8) {
+                case 0:
+                    subscribe();
+                    break;
+                case 1:
+                    handler.unsubscribe<ping>(*self);
+                    alive.erase(*self);
+                    if (*token != 1) {
+                        ++errors;
+                    }
+                    break;
+                case 2:
+                    if (!live.empty()) {
+                        auto i = rng() % live.size();
+                        handler.unsubscribe<ping>(live[i]);
+                        alive.erase(live[i]);
+                        live[i] = live.back();
+                        live.pop_back();
+                    }
+                    break;
+                case 3:
+                    if (e.depth < 3 && rng() % 4096 == 0) {
+                        handler.publish(ping{e.depth + 1});
+                    }
+                    break;
+                default:
+                    break;
+            }
+        });
+        live.push_back(*self);
+        alive.insert(*self);
+    }
+};
+
+bool run_churn() {
+    stress s;
+    for (int i = 0; i < 5000; ++i) {
+        s.subscribe();
+    }
+    for (int i = 0; i < 50; ++i) {
+        s.handler.publish(ping{0});
+    }
+    std::printf("churn: %ld calls, %zu subscribed at the end, %ld errors\n", s.calls, s.alive.size(), s.errors);
+    return s.errors == 0 && s.calls > 0;
+}
+
+bool run_no_allocations() {
+    nsc::counting_resource resource;
+    nsc::event_handler handler(&resource);
+    long sum = 0;
+    for (int i = 0; i < 1000; ++i) {
+        handler.subscribe<ping>([&sum](const ping& e) { sum += e.depth; });
+    }
+    resource.reset_counters();
+    for (int i = 0; i < 100; ++i) {
+        handler.publish(ping{1});
+    }
+    std::printf("publish: %zu allocations\n", resource.allocations());
+    return resource.allocations() == 0 && sum == 100'000;
+}
+
+}  // namespace
+
+int main() {
+    bool ok = run_churn();
+    ok = run_no_allocations() && ok;
+    return ok ? 0 : 1;
+}
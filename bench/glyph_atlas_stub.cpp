@@ -0,0 +1,22 @@
+// The benchmarks build without GL and msdf-atlas-gen, so their fonts have
+// no GlyphAtlas. These definitions only let text_measure.cpp link.
+
+#include "framework/rendering/glyph_atlas.hpp"
+
+GlyphAtlas::GlyphAtlas(const std::string &font_path)
+	: font_path(font_path), outstanding(0), revision(0), stop(false)
+{
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+}
+
+const GlyphMetrics *GlyphAtlas::find(uint32_t)
+{
+	return nullptr;
+}
+
+void GlyphAtlas::upload()
+{
+}
@@ -0,0 +1,102 @@
+// Compares the sparse-set nsc::group with the sorted vector it replaced,
+// at 1e3, 1e5 and 1e6 entries, and writes the results as JSON. See
+// bench.hpp for the flags.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "bench.hpp"
+#include "framework/core/registry.hpp"
+#include "legacy_group.hpp"
+
+namespace {
+
+using nsc::bench::do_not_optimize;
+using nsc::bench::reporter;
+using nsc::bench::time_ns;
+
+struct rect {
+    float x, y, w, h;
+};
+
+template <typename Group>
+auto fill(Group& group, std::size_t n) {
+    std::vector<decltype(group.emplace(0.0f, 0.0f, 0.0f, 0.0f))> handles;
+    handles.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        handles.push_back(group.emplace(static_cast<float>(i), 0.0f, 1.0f, 1.0f));
+    }
+    return handles;
+}
+
+template <typename Group>
+float sum(const Group& group) {
+    float total = 0.0f;
+    for (const auto& r : group) {
+        total += r.x;
+    }
+    return total;
+}
+
+template <typename Group>
+void bench_group(reporter& report, const std::string& prefix, std::size_t n) {
+    std::mt19937 rng(42);
+    auto name = [&](const char* test) { return prefix + "/" + test; };
+
+    report.run(name("create").c_str(), n, n, [&] {
+        Group group;
+        return time_ns([&] { do_not_optimize(fill(group, n)); });
+    });
+
+    report.run(name("get_shuffled").c_str(), n, n, [&] {
+        Group group;
+        auto handles = fill(group, n);
+        std::shuffle(handles.begin(), handles.end(), rng);
+        return time_ns([&] {
+            float total = 0.0f;
+            for (auto handle : handles) {
+                total += group.get(handle)->x;
+            }
+            do_not_optimize(total);
+        });
+    });
+
+    report.run(name("remove_half").c_str(), n, n / 2, [&] {
+        Group group;
+        auto handles = fill(group, n);
+        std::shuffle(handles.begin(), handles.end(), rng);
+        return time_ns([&] {
+            for (std::size_t i = 0; i < n / 2; ++i) {
+                group.remove(handles[i]);
+            }
+        });
+    });
+
+    report.run(name("iterate_after_remove").c_str(), n, n - n / 2, [&] {
+        Group group;
+        auto handles = fill(group, n);
+        std::shuffle(handles.begin(), handles.end(), rng);
+        // One short of the half, so the old group has not compacted yet.
+        for (std::size_t i = 0; i + 1 < n / 2; ++i) {
+            group.remove(handles[i]);
+        }
+        const auto& view = group;
+        return time_ns([&] { do_not_optimize(sum(view)); });
+    });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    auto opts = nsc::bench::parse_options(argc, argv);
+    reporter report(opts);
+    for (std::size_t n : {1'000, 100'000, 1'000'000}) {
+        if (n > opts.sizes.back()) {
+            break;
+        }
+        bench_group<nsc::legacy::group<rect>>(report, "legacy_group", n);
+        bench_group<nsc::group<rect>>(report, "group", n);
+    }
+    return report.write_json() ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// nsc::group as it was before it became a sparse set, kept so group_bench
+// can compare against it. Entries are sorted by handle, looked up by binary
+// search and removed by leaving an empty optional behind until half of them
+// are empty.
+//
+// Two bugs of the original are fixed so that it is timed as it was meant to
+// work: size_ starts at zero, and compaction erases every empty entry
+// rather than only the first.
+namespace nsc::legacy {
+using obj_handle = int;
+
+template <typename T>
+class group {
+    struct obj_pair {
+        obj_handle handle;
+        std::optional<T> value;
+    };
+
+   public:
+    class const_iterator final {
+       public:
+        using It = typename std::vector<obj_pair>::const_iterator;
+
+        const_iterator(It from, It to) noexcept : it{from}, end{to} {
+            if (it != end && !it->value) {
+                ++(*this);
+            }
+        }
+
+        const_iterator& operator++() {
+            while (++it != end && !it->value) {
+            }
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const noexcept { return other.it == it; }
+        bool operator!=(const const_iterator& other) const noexcept { return !(*this == other); }
+
+        const T& operator*() const { return *it->value; }
+
+       private:
+        It it;
+        It end;
+    };
+
+    const_iterator begin() const { return {registry_.begin(), registry_.end()}; }
+    const_iterator end() const { return {registry_.end(), registry_.end()}; }
+
+    template <typename... Args>
+    obj_handle emplace(Args... args) {
+        auto handle = _generate_next_obj_id();
+        registry_.push_back(obj_pair{handle, T{std::forward<Args>(args)...}});
+        ++size_;
+        return handle;
+    }
+
+    T* get(const obj_handle& handle) {
+        auto pos = _find(handle);
+        if (pos == registry_.end() || pos->handle != handle || !pos->value) {
+            return nullptr;
+        }
+        return &(*(pos->value));
+    }
+
+    void remove(const obj_handle& handle) {
+        auto pos = _find(handle);
+        if (pos == registry_.end() || pos->handle != handle || !pos->value) {
+            return;
+        }
+
+        pos->value.reset();
+        --size_;
+
+        if (size_ < (registry_.size() / 2)) {
+            registry_.erase(std::remove_if(registry_.begin(), registry_.end(), [](const auto& e) { return !e.value; }),
+                            registry_.end());
+        }
+    }
+
+   private:
+    typename std::vector<obj_pair>::iterator _find(const obj_handle& handle) {
+        return std::lower_bound(registry_.begin(), registry_.end(), handle,
+                                [](const auto& a, const auto& b) { return a.handle < b; });
+    }
+
+    inline obj_handle _generate_next_obj_id() noexcept {
+        static obj_handle id_ = 0;
+        return id_++;
+    }
+
+    std::size_t size_ = 0;
+    std::vector<obj_pair> registry_;
+};
+}  // namespace nsc::legacy
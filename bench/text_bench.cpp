@@ -0,0 +1,147 @@
+// Times measure_text over a million characters of ASCII, of mostly ASCII
+// with accented letters, and of Cyrillic, against decoding and looking up
+// one codepoint at a time. Fails if measure_text gets the size wrong.
+// Writes the results as JSON; see bench.hpp for the flags.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "bench.hpp"
+#include "framework/core/utf8.hpp"
+#include "framework/rendering/text_measure.hpp"
+
+namespace {
+
+using nsc::bench::do_not_optimize;
+using nsc::bench::reporter;
+using nsc::bench::time_ns;
+
+constexpr std::size_t text_length = 1'000'000;
+constexpr std::size_t font_size = 16;
+
+// Made-up metrics for printable ASCII, Latin-1 and Cyrillic, the last of
+// which lands in the table's hash map.
+void fill_font(Font &font) {
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> unit(0.3f, 0.7f);
+	auto add = [&](uint32_t codepoint) {
+		GlyphMetrics m {};
+		m.advance = unit(rng);
+		m.plane_right = m.advance * 0.9f;
+		m.plane_bottom = -0.2f * unit(rng);
+		m.plane_top = unit(rng) + 0.3f;
+		font.glyphs.set(codepoint, m);
+	};
+	for (uint32_t c = ' '; c < 0x7F; ++c) {
+		add(c);
+	}
+	for (uint32_t c = 0xA0; c < 0x100; ++c) {
+		add(c);
+	}
+	for (uint32_t c = 0x400; c < 0x500; ++c) {
+		add(c);
+	}
+}
+
+void append_utf8(std::string &out, uint32_t codepoint) {
+	if (codepoint < 0x80) {
+		out += (char)codepoint;
+	} else {
+		out += (char)(0xC0 | (codepoint >> 6));
+		out += (char)(0x80 | (codepoint & 0x3F));
+	}
+}
+
+// Words of pick() separated by spaces, length codepoints long.
+template <typename Pick>
+std::string make_text(Pick &&pick) {
+	std::mt19937 rng(5);
+	std::string text;
+	for (std::size_t i = 0; i < text_length; ++i) {
+		append_utf8(text, rng() % 7 == 0 ? ' ' : pick(rng));
+	}
+	return text;
+}
+
+// What laying out did per codepoint before measure_text was used for it.
+TextExtents measure_reference(Font &font, std::string_view msg) {
+	auto width = 0.f;
+	auto height = 0.f;
+	std::size_t i = 0;
+	while (i < msg.size()) {
+		auto codepoint = nsc::utf8_next(msg, i);
+		auto glyph = choose_glyph(font, codepoint).glyph;
+		width += glyph->advance * font_size;
+		if (codepoint != ' ' && glyph->plane_right > glyph->plane_left) {
+			height = std::max(height, (glyph->plane_top - glyph->plane_bottom) * font_size);
+		}
+	}
+	return TextExtents { width, height, false };
+}
+
+// The width to check measure_text against, summed in double.
+double exact_width(Font &font, std::string_view msg) {
+	auto width = 0.0;
+	std::size_t i = 0;
+	while (i < msg.size()) {
+		width += choose_glyph(font, nsc::utf8_next(msg, i)).glyph->advance;
+	}
+	return width * font_size;
+}
+
+// Checked on a prefix: over the whole million characters any float sum,
+// the reference's included, drifts by parts in 1e3.
+bool check(Font &font, const std::string &name, std::string_view text) {
+	auto end = std::min<std::size_t>(text.size(), 10'000);
+	while (end < text.size() && (text[end] & 0xC0) == 0x80) {
+		--end;
+	}
+	text = text.substr(0, end);
+
+	auto fast = measure_text(font, font_size, text);
+	auto reference = measure_reference(font, text);
+	auto exact = exact_width(font, text);
+	if (std::abs(fast.width - exact) > exact * 1e-5 || fast.height != reference.height) {
+		std::fprintf(stderr, "%s: measure_text gave %f x %f, expected %f x %f\n", name.c_str(), fast.width,
+					 fast.height, exact, reference.height);
+		return false;
+	}
+	return true;
+}
+
+bool bench_text(reporter &report, Font &font, const std::string &name, const std::string &text) {
+	if (!check(font, name, text)) {
+		return false;
+	}
+
+	report.run(("measure_text/" + name).c_str(), text_length, text_length, [&] {
+		return time_ns([&] { do_not_optimize(measure_text(font, font_size, text)); });
+	});
+	report.run(("measure_reference/" + name).c_str(), text_length, text_length, [&] {
+		return time_ns([&] { do_not_optimize(measure_reference(font, text)); });
+	});
+	return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	auto opts = nsc::bench::parse_options(argc, argv);
+	reporter report(opts);
+
+	Font font {};
+	fill_font(font);
+
+	auto ascii = make_text([](auto &rng) { return (uint32_t)('a' + rng() % 26); });
+	auto latin1 = make_text([](auto &rng) { return rng() % 20 == 0 ? 0xE0 + rng() % 32 : 'a' + rng() % 26; });
+	auto cyrillic = make_text([](auto &rng) { return (uint32_t)(0x430 + rng() % 32); });
+
+	auto ok = bench_text(report, font, "ascii", ascii);
+	ok = bench_text(report, font, "latin1", latin1) && ok;
+	ok = bench_text(report, font, "cyrillic", cyrillic) && ok;
+	return report.write_json() && ok ? 0 : 1;
+}
@@ -20,6 +20,8 @@ App::App(int window_width, int window_height) {
     window->register_mouse_click_callback(
         std::bind(&App::handle_mouse_click, this, std::placeholders::_1,
                   std::placeholders::_2, std::placeholders::_3));
+
+    event_handler.coalesce<WindowResizeEvent>(nsc::coalesce_mode::latest);
 }
 
 App::~App() {}
@@ -39,12 +41,39 @@ void App::main_loop() {
 void App::update() {
     window->pre_update();
     window->update();
+    dispatch_queued_events();
+    flush_events();
     process_callbacks();
+    scheduler.run();
     window->post_update();
+    delete_released_elements();
 }
 
 void App::render() {
     renderer->render(canvas.get(), window.get(), camera.get());
+    canvas->clear_changes();
+}
+
+void App::dispatch_queued_events() {
+    event_handler.dispatch_queued();
+    for (auto element : elements) {
+        element->visit([](nsc::ui::Element &e) {
+            e.event_handler.dispatch_queued();
+            e.capture_handler.dispatch_queued();
+        });
+    }
+}
+
+// Window callbacks run inside post_update's glfwPollEvents, so whatever they
+// coalesced last frame is delivered here, once.
+void App::flush_events() {
+    event_handler.flush();
+    for (auto element : elements) {
+        element->visit([](nsc::ui::Element &e) {
+            e.event_handler.flush();
+            e.capture_handler.flush();
+        });
+    }
 }
 
 void App::process_callbacks() {
@@ -52,10 +81,11 @@ void App::process_callbacks() {
     cursor_x = window->get_cursor_x();
     cursor_y = window->get_cursor_y();
 
+    // Later roots are on top; within a root the deepest element wins.
     nsc::ui::Element *focused = nullptr;
     for (auto element : elements) {
-        if (element->bounds.is_inside(cursor_x, cursor_y)) {
-            focused = element;
+        if (auto hit = element->hit_test(cursor_x, cursor_y)) {
+            focused = hit;
         }
     }
 
@@ -108,7 +138,7 @@ void App::handle_mouse_click(int button, int action, int mods) {
         if (curr_focused) {
             //     event_handler.publish<MouseClickEvent>(
             //        MouseClickEvent{curr_focused->id, cursor_x, cursor_y});
-            curr_focused->publish_on<MouseClickEvent>(
+            curr_focused->route_event<MouseClickEvent>(
                 MouseClickEvent{curr_focused->id, cursor_x, cursor_y});
         }
     }
@@ -118,7 +148,7 @@ void App::handle_char_input(unsigned int codepoint) {
     if (curr_focused) {
         // event_handler.publish<CharInputEvent>(
         //    CharInputEvent{curr_focused->id, (char)codepoint});
-        curr_focused->publish_on<CharInputEvent>(
+        curr_focused->route_event<CharInputEvent>(
             CharInputEvent{curr_focused->id, (char)codepoint});
     }
 }
@@ -139,6 +169,27 @@ void App::remove(nsc::ui::Element *element) {
                    elements.end());
 }
 
+// Runs once nothing is dispatching any more: every callback of the frame,
+// window callbacks included, has returned. The app forgets released elements
+// before they are deleted, so hover and focus never point at freed memory.
+void App::delete_released_elements() {
+    for (auto element : nsc::ui::Element::get_released()) {
+        if (curr_hover == element) {
+            curr_hover = nullptr;
+        }
+        if (curr_focused == element) {
+            curr_focused = nullptr;
+        }
+        remove(element);
+    }
+    nsc::ui::Element::delete_released();
+}
+
+void App::spawn(nsc::task task) { scheduler.spawn(std::move(task)); }
+
+bool App::record_input(const std::string &path) { return window->record_input(path); }
+bool App::replay_input(const std::string &path) { return window->replay_input(path); }
+
 void App::set_background_color(const nsc::rendering::Color &color) {
     // canvas->set_bg_color(color);
 }
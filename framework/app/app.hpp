@@ -10,6 +10,7 @@
 #include <utility>
 
 #include "../rendering/camera.hpp"
+#include "../core/coroutine.hpp"
 #include "../core/registry.hpp"
 #include "../ui/element.hpp"
 #include "../core/event_handler.hpp"
@@ -23,12 +24,23 @@ class App {
     ~App();
 
     void start();
+    // Adds a root element; its children are reached through it.
     void add(nsc::ui::Element *element);
     void remove(nsc::ui::Element *element);
     void process_callbacks();
+    void dispatch_queued_events();
+    void flush_events();
 
     void set_background_color(const nsc::rendering::Color &color);
 
+    // Starts an interaction coroutine. Tasks waiting on events or frames are
+    // resumed from update(), after the frame's events have been dispatched.
+    void spawn(nsc::task task);
+
+    // See Window::record_input and Window::replay_input. Call before start().
+    bool record_input(const std::string &path);
+    bool replay_input(const std::string &path);
+
     template <typename Event, typename Connection>
     nsc::event_handle subscribe(Connection &&conn) {
         return event_handler.subscribe<Event>(std::move(conn));
@@ -36,7 +48,33 @@ class App {
 
     template <typename Event>
     void unsubscribe(const nsc::event_handle handle) {
-        return event_handler.unsubscribe(handle);
+        return event_handler.unsubscribe<Event>(handle);
+    }
+
+    // Returns a queue that background threads can push Events into without
+    // blocking. They are published on the UI thread at the start of the next
+    // frame's callback processing.
+    template <typename Event>
+    nsc::event_queue<Event> *make_event_queue(std::size_t capacity) {
+        return event_handler.make_queue<Event>(capacity);
+    }
+
+    // Events published on the app are held and delivered once per frame
+    // according to mode. WindowResizeEvent is coalesced to the latest by
+    // default.
+    template <typename Event>
+    void coalesce(nsc::coalesce_mode mode) {
+        event_handler.coalesce<Event>(mode);
+    }
+
+    template <typename Event, typename Merge>
+    void coalesce(Merge &&merge) {
+        event_handler.coalesce<Event>(std::forward<Merge>(merge));
+    }
+
+    template <typename Event, typename Connection>
+    nsc::event_handle subscribe_batch(Connection &&conn) {
+        return event_handler.subscribe_batch<Event>(std::move(conn));
     }
 
    protected:
@@ -51,12 +89,14 @@ class App {
     void handle_char_input(unsigned int codepoint);
     void handle_key(int key, int scancode, int action, int mods);
     void handle_window_resize(int width, int height);
+    void delete_released_elements();
 
     nsc::event_handler event_handler;
+    nsc::scheduler scheduler;
 
     std::vector<nsc::ui::Element *> elements;
-    nsc::ui::Element *curr_focused;
-    nsc::ui::Element *curr_hover;
+    nsc::ui::Element *curr_focused = nullptr;
+    nsc::ui::Element *curr_hover = nullptr;
 
     std::unique_ptr<Renderer> renderer;
     std::unique_ptr<Window> window;
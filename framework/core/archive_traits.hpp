@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string_view>
+#include <type_traits>
+
+namespace nsc {
+
+// How registry_archive writes a T to disk and reads it back.
+//
+// stored must be trivially copyable, since values are written and read as
+// raw bytes. key names the group in the file and must stay the same across
+// builds. By default a T is stored as is and its key is T::archive_key.
+// Types holding pointers (to textures, fonts, ...) specialize this to store
+// an asset_id instead and look the pointer up again in from_stored.
+template <typename T>
+struct archive_traits {
+    using stored = T;
+
+    static constexpr std::string_view key = T::archive_key;
+
+    static stored to_stored(const T& value) { return value; }
+
+    template <typename Context>
+    static T from_stored(const stored& value, Context&) { return value; }
+};
+
+}  // namespace nsc
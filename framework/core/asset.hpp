@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace nsc {
+
+namespace detail {
+
+// 64-bit FNV-1a.
+inline constexpr std::uint64_t fnv1a(std::string_view bytes) noexcept {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (auto c : bytes) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}  // namespace detail
+
+// Names an asset (a texture, a font, ...) independently of where it happens
+// to be loaded in memory, so descs can be written to disk and read back in a
+// later run. Derived from the asset's path, so it is stable across runs.
+using asset_id = std::uint64_t;
+
+inline constexpr asset_id null_asset = 0;
+
+inline constexpr asset_id make_asset_id(std::string_view path) noexcept {
+    auto hash = detail::fnv1a(path);
+    return hash == null_asset ? 1 : hash;
+}
+
+// Tells the catalogs apart in an asset_table. The values are written to disk.
+enum class asset_kind : std::uint32_t {
+    texture = 1,
+    font = 2,
+};
+
+// Where to load each asset a saved scene refers to. The catalogs fill one in
+// before saving and load from one after restoring.
+class asset_table {
+   public:
+    struct entry {
+        asset_kind kind;
+        std::string path;
+        // Whatever else the owning catalog needs to load the asset the same
+        // way again.
+        std::uint32_t flags;
+    };
+
+    void add(asset_id id, asset_kind kind, const std::string& path, std::uint32_t flags = 0) {
+        entries_[id] = entry{kind, path, flags};
+    }
+
+    const entry* find(asset_id id) const {
+        auto it = entries_.find(id);
+        return it == entries_.end() ? nullptr : &it->second;
+    }
+
+    const std::unordered_map<asset_id, entry>& entries() const noexcept { return entries_; }
+
+   private:
+    std::unordered_map<asset_id, entry> entries_;
+};
+
+}  // namespace nsc
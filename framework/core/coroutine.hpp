@@ -0,0 +1,201 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "event_handler.hpp"
+#include "memory.hpp"
+
+namespace nsc {
+
+class scheduler;
+
+namespace detail {
+// Coroutine frames come from a per-thread pool, so starting an interaction
+// reuses the frame of one that already finished instead of going to the
+// heap. Tasks must be created and destroyed on the same thread.
+inline std::pmr::memory_resource* frame_resource() {
+    thread_local pool_resource pool;
+    return &pool;
+}
+}  // namespace detail
+
+// A coroutine that runs an interaction to completion, suspending on
+// next_event and next_frame awaitables:
+//
+//     nsc::task drag(nsc::ui::Element& handle) {
+//         auto press = co_await handle.next<MouseClickEvent>();
+//         while (...) {
+//             co_await nsc::next_frame();
+//         }
+//     }
+//
+//     app.spawn(drag(element));
+//
+// A task does nothing until it is handed to a scheduler, which then owns
+// it and destroys it once it finishes.
+class task {
+   public:
+    struct promise_type {
+        scheduler* owner = nullptr;
+        std::size_t slot = 0;
+
+        task get_return_object() noexcept {
+            return task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+
+        static void* operator new(std::size_t size) {
+            return detail::frame_resource()->allocate(size, alignof(std::max_align_t));
+        }
+        static void operator delete(void* p, std::size_t size) {
+            detail::frame_resource()->deallocate(p, size, alignof(std::max_align_t));
+        }
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+   private:
+    friend class scheduler;
+
+    explicit task(handle_type handle) noexcept : handle_(handle) {}
+
+    handle_type release() noexcept { return std::exchange(handle_, {}); }
+
+    handle_type handle_;
+};
+
+// Owns spawned tasks and resumes the ones that became ready, once per
+// run(). Everything runs on the thread that calls run(); App calls it once
+// per frame from update(), after events have been dispatched.
+class scheduler {
+   public:
+    scheduler() = default;
+    scheduler(const scheduler&) = delete;
+    scheduler& operator=(const scheduler&) = delete;
+
+    ~scheduler() {
+        for (auto handle : tasks_) {
+            handle.destroy();
+        }
+    }
+
+    // Starts t right away; it runs until its first suspension.
+    void spawn(task t) {
+        auto handle = t.release();
+        if (!handle) {
+            return;
+        }
+        handle.promise().owner = this;
+        handle.promise().slot = tasks_.size();
+        tasks_.push_back(handle);
+        _resume(handle);
+    }
+
+    // Resumes h on the next run().
+    void schedule(std::coroutine_handle<> h) { ready_.push_back(h); }
+
+    // Resumes every task that became ready before this call. Tasks that
+    // become ready while it runs wait for the next one.
+    void run() {
+        std::swap(ready_, running_);
+        for (auto h : running_) {
+            _resume(task::handle_type::from_address(h.address()));
+        }
+        running_.clear();
+    }
+
+    std::size_t size() const noexcept { return tasks_.size(); }
+
+   private:
+    void _resume(task::handle_type handle) {
+        handle.resume();
+        if (handle.done()) {
+            auto slot = handle.promise().slot;
+            tasks_[slot] = tasks_.back();
+            tasks_[slot].promise().slot = slot;
+            tasks_.pop_back();
+            handle.destroy();
+        }
+    }
+
+    std::vector<task::handle_type> tasks_;
+    std::vector<std::coroutine_handle<>> ready_;
+    std::vector<std::coroutine_handle<>> running_;
+};
+
+// Suspends until handler next publishes an E and evaluates to that event.
+// Only usable inside a task. handler must outlive the waiting task.
+template <typename E>
+class next_event {
+   public:
+    explicit next_event(event_handler& handler) noexcept : handler_(&handler) {}
+
+    next_event(const next_event&) = delete;
+    next_event& operator=(const next_event&) = delete;
+
+    // A task destroyed while still waiting stops listening.
+    ~next_event() {
+        if (waiting_) {
+            handler_->unsubscribe<E>(handle_);
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(task::handle_type awaiting) {
+        auto owner = awaiting.promise().owner;
+        handle_ = handler_->subscribe<E>([this, owner, awaiting](const E& e) {
+            // Subscriptions may change during publish, so the awaiter can
+            // unhook itself here and is not called again.
+            value_.emplace(e);
+            waiting_ = false;
+            handler_->unsubscribe<E>(handle_);
+            owner->schedule(awaiting);
+        });
+        waiting_ = true;
+    }
+
+    E await_resume() { return std::move(*value_); }
+
+   private:
+    event_handler* handler_;
+    event_handle handle_ = 0;
+    bool waiting_ = false;
+    std::optional<E> value_;
+};
+
+// Suspends until the next scheduler run, i.e. the next frame.
+struct next_frame {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(task::handle_type awaiting) { awaiting.promise().owner->schedule(awaiting); }
+    void await_resume() const noexcept {}
+};
+
+}  // namespace nsc
@@ -1,60 +1,285 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
-#include <functional>
 #include <memory>
-#include <optional>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "event_queue.hpp"
+#include "inplace_function.hpp"
+#include "memory.hpp"
+#include "type_index.hpp"
+
 namespace nsc::detail {
-struct _event_registry {};
+struct _event_registry {
+    virtual ~_event_registry() = default;
+
+    virtual void dispatch_queued() = 0;
+    virtual void flush() = 0;
+};
 }  // namespace nsc::detail
 
 namespace nsc {
 using event_handle = size_t;
+}  // namespace nsc
+
+namespace nsc::detail {
+// A list of subscribed callbacks that the callbacks themselves may subscribe
+// to or unsubscribe from while it is being called, including from nested
+// calls.
+//
+// While any call is running, subscriptions go to a side list and removals
+// only deactivate their slot, so the slots being iterated never move and a
+// callback that removes itself stays alive until it returns. The outermost
+// call applies the deferred changes when it finishes. Calling never
+// allocates.
+template <typename Callback>
+class callback_list {
+   public:
+    explicit callback_list(std::pmr::memory_resource* resource)
+        : slots_(resource), added_(resource) {}
+
+    void add(event_handle handle, Callback&& callback) {
+        if (depth_ > 0) {
+            added_.push_back(slot{handle, std::move(callback), true});
+            deferred_ = true;
+        } else {
+            slots_.push_back(slot{handle, std::move(callback), true});
+        }
+        ++size_;
+    }
+
+    // Returns false if handle is not in this list.
+    bool remove(event_handle handle) {
+        auto target = _find(slots_, handle);
+        if (!target) {
+            target = _find(added_, handle);
+        }
+        if (!target) {
+            return false;
+        }
+        if (!target->active) {
+            return true;
+        }
+
+        target->active = false;
+        --size_;
+        if (depth_ > 0) {
+            deferred_ = true;
+            return true;
+        }
+
+        target->callback.reset();
+        if (size_ < (slots_.size() / 2)) {
+            _compact();
+        }
+        return true;
+    }
+
+    // Callbacks subscribed during the call are first called on the next one;
+    // callbacks unsubscribed during it are skipped from then on.
+    template <typename... Args>
+    void call(const Args&... args) {
+        call_guard guard(*this);
+        auto slots = slots_.data();
+        auto count = slots_.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            if (slots[i].active) {
+                slots[i].callback(args...);
+            }
+        }
+    }
+
+    bool empty() const noexcept { return size_ == 0; }
+
+   private:
+    struct slot {
+        event_handle handle;
+        Callback callback;
+        bool active;
+    };
+
+    struct call_guard {
+        explicit call_guard(callback_list& list) : list(list) { ++list.depth_; }
+        ~call_guard() {
+            if (--list.depth_ == 0 && list.deferred_) {
+                list._apply_deferred();
+            }
+        }
+        callback_list& list;
+    };
+
+    static slot* _find(std::pmr::vector<slot>& slots, event_handle handle) {
+        auto pos = std::lower_bound(
+            slots.begin(), slots.end(), handle,
+            [](const auto& a, const auto& b) { return a.handle < b; });
+        if (pos == slots.end() || pos->handle != handle) {
+            return nullptr;
+        }
+        return &*pos;
+    }
+
+    void _compact() {
+        slots_.erase(
+            std::remove_if(slots_.begin(), slots_.end(),
+                           [](const auto& s) { return !s.active; }),
+            slots_.end());
+    }
+
+    // Handles only grow, so appending the added slots keeps slots_ sorted.
+    void _apply_deferred() {
+        deferred_ = false;
+        _compact();
+        for (auto& added : added_) {
+            if (added.active) {
+                slots_.push_back(std::move(added));
+            }
+        }
+        added_.clear();
+    }
+
+    std::pmr::vector<slot> slots_;
+    std::size_t size_ = 0;
+    std::size_t depth_ = 0;
+    bool deferred_ = false;
+    std::pmr::vector<slot> added_;
+};
+}  // namespace nsc::detail
+
+namespace nsc {
+
+// How an event type is delivered. With anything but none, publish only
+// records the event and subscribers see the result on the next flush:
+//   latest      - the most recent event since the last flush
+//   accumulate  - every event folded into the first by a merge function
+//   batch       - every event, in order; batch subscribers get them as one span
+enum class coalesce_mode { none, latest, accumulate, batch };
 
 template <class E>
 class event_callback_registry : public detail::_event_registry {
    public:
-    typedef std::function<void(const E&)> Callback;
+    // Captures of up to Callback::capacity bytes are stored inline, so
+    // subscribing does not allocate beyond the callback list itself.
+    typedef inplace_function<void(const E&)> Callback;
+    typedef inplace_function<void(std::span<const E>)> BatchCallback;
+    typedef inplace_function<void(E&, const E&)> Merge;
+
+    explicit event_callback_registry(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : callbacks_(resource), batch_callbacks_(resource), pending_(resource), flushing_(resource) {}
 
+    // Safe to call from inside one of this registry's callbacks; see
+    // detail::callback_list.
     event_handle subscribe(Callback&& c) {
         auto handle = _get_next_event_handle();
-        callbacks_.emplace_back(handle, std::move(c));
-        ++size_;
+        callbacks_.add(handle, std::move(c));
+        return handle;
+    }
+
+    // Batch subscribers get a span of every event delivered in one go: all
+    // of a frame's events in batch mode, otherwise a span of one.
+    event_handle subscribe_batch(BatchCallback&& c) {
+        auto handle = _get_next_event_handle();
+        batch_callbacks_.add(handle, std::move(c));
         return handle;
     }
 
     void unsubscribe(const event_handle handle) {
-        auto pos = std::lower_bound(
-            callbacks_.begin(), callbacks_.end(), handle,
-            [](const auto& a, const auto& b) { return a.first < b; });
-        if (pos == callbacks_.end() || pos->first != handle) {
-            return;
+        if (!callbacks_.remove(handle)) {
+            batch_callbacks_.remove(handle);
         }
+    }
 
-        pos->second.reset();
-        --size_;
+    void publish(const E& e) {
+        switch (mode_) {
+            case coalesce_mode::none:
+                _dispatch(e);
+                break;
+            case coalesce_mode::latest:
+                if (pending_.empty()) {
+                    pending_.push_back(e);
+                } else {
+                    pending_.front() = e;
+                }
+                break;
+            case coalesce_mode::accumulate:
+                if (pending_.empty()) {
+                    pending_.push_back(e);
+                } else if (merge_) {
+                    merge_(pending_.front(), e);
+                } else {
+                    pending_.front() = e;
+                }
+                break;
+            case coalesce_mode::batch:
+                pending_.push_back(e);
+                break;
+        }
+    }
 
-        if (size_ < (callbacks_.size() / 2)) {
-            callbacks_.erase(
-                std::remove_if(callbacks_.begin(), callbacks_.end(),
-                               [](const auto& e) { return !e.second; }));
+    // Switching back to none flushes whatever is still pending.
+    void coalesce(coalesce_mode mode, Merge&& merge = {}) {
+        if (mode == coalesce_mode::none) {
+            flush();
         }
+        mode_ = mode;
+        merge_ = std::move(merge);
     }
 
-    void publish(const E& e) {
-        for (auto& callback : callbacks_) {
-            if (callback.second) {
-                (*callback.second)(e);
+    // Delivers what publish recorded since the last flush. Events published
+    // by the subscribers themselves are held for the next one.
+    void flush() override {
+        if (pending_.empty() || !flushing_.empty()) {
+            return;
+        }
+
+        std::swap(pending_, flushing_);
+        if (mode_ == coalesce_mode::batch) {
+            for (const auto& e : flushing_) {
+                callbacks_.call(e);
             }
+            batch_callbacks_.call(std::span<const E>(flushing_));
+        } else {
+            _dispatch(flushing_.front());
+        }
+        flushing_.clear();
+    }
+
+    event_queue<E>* make_queue(std::size_t capacity) {
+        if (!queue_) {
+            auto resource = pending_.get_allocator().resource();
+            queue_ = make_pmr_unique<event_queue<E>>(resource, capacity, resource);
+        }
+        return queue_.get();
+    }
+
+    // Publishes whatever other threads pushed into the queue since the last
+    // call.
+    void dispatch_queued() override {
+        if (queue_) {
+            queue_->drain([this](const E& e) { publish(e); });
         }
     }
 
    private:
-    std::vector<std::pair<event_handle, std::optional<Callback>>> callbacks_;
-    size_t size_;
+    // What publish touches comes first.
+    coalesce_mode mode_ = coalesce_mode::none;
+    detail::callback_list<Callback> callbacks_;
+    detail::callback_list<BatchCallback> batch_callbacks_;
+    pmr_ptr<event_queue<E>> queue_;
+    Merge merge_;
+    std::pmr::vector<E> pending_;
+    std::pmr::vector<E> flushing_;
+
+    void _dispatch(const E& e) {
+        callbacks_.call(e);
+        if (!batch_callbacks_.empty()) {
+            batch_callbacks_.call(std::span<const E>(&e, 1));
+        }
+    }
 
     inline event_handle _get_next_event_handle() noexcept {
         static event_handle id_ = 0;
@@ -64,19 +289,30 @@ class event_callback_registry : public detail::_event_registry {
 
 class event_handler {
    public:
+    // The per-event registries and their callback lists are allocated from
+    // resource. Callables too large for an inplace_function still use the
+    // global heap.
+    explicit event_handler(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : registries_(resource), queued_registries_(resource), coalesced_registries_(resource) {}
+
     template <typename E, typename Connection>
     event_handle subscribe(Connection&& conn) {
         auto reg = _get_registry<E>();
         if (!reg) {
-            auto id = _get_event_registry_id<E>();
-            registries_.emplace_back(
-                id, std::make_unique<event_callback_registry<E>>());
-            reg = _get_registry<E>();
-            ++size_;
+            reg = _make_registry<E>();
         }
         return reg->subscribe(std::move(conn));
     }
 
+    template <typename E, typename Connection>
+    event_handle subscribe_batch(Connection&& conn) {
+        auto reg = _get_registry<E>();
+        if (!reg) {
+            reg = _make_registry<E>();
+        }
+        return reg->subscribe_batch(std::move(conn));
+    }
+
     template <typename E>
     void publish(const E& e) {
         if (auto reg = _get_registry<E>(); reg) {
@@ -91,35 +327,100 @@ class event_handler {
         }
     }
 
+    // Returns the queue through which other threads can post Es to this
+    // handler, creating it with the given capacity on first use. Must be
+    // called on the thread that owns the handler; the returned queue may
+    // then be pushed to from any thread. Queued events are published on the
+    // next dispatch_queued().
+    template <typename E>
+    event_queue<E>* make_queue(std::size_t capacity) {
+        auto reg = _get_registry<E>();
+        if (!reg) {
+            reg = _make_registry<E>();
+        }
+
+        _track(queued_registries_, reg);
+        return reg->make_queue(capacity);
+    }
+
+    void dispatch_queued() {
+        // By index: a callback may create another queue.
+        for (std::size_t i = 0; i < queued_registries_.size(); ++i) {
+            queued_registries_[i]->dispatch_queued();
+        }
+    }
+
+    // Holds Es published from now on until the next flush() and delivers
+    // them according to mode. Use the overload below for accumulate.
+    template <typename E>
+    void coalesce(coalesce_mode mode) {
+        auto reg = _get_registry<E>();
+        if (!reg) {
+            reg = _make_registry<E>();
+        }
+        _track(coalesced_registries_, reg);
+        reg->coalesce(mode);
+    }
+
+    // Accumulates Es between flushes with merge(E& into, const E& next).
+    template <typename E, typename Merge>
+        requires std::is_invocable_v<Merge&, E&, const E&>
+    void coalesce(Merge&& merge) {
+        auto reg = _get_registry<E>();
+        if (!reg) {
+            reg = _make_registry<E>();
+        }
+        _track(coalesced_registries_, reg);
+        reg->coalesce(coalesce_mode::accumulate, std::forward<Merge>(merge));
+    }
+
+    // Delivers every coalesced event type's pending events. Meant to be
+    // called once per frame.
+    void flush() {
+        for (std::size_t i = 0; i < coalesced_registries_.size(); ++i) {
+            coalesced_registries_[i]->flush();
+        }
+    }
+
    private:
-    using event_registry_id = std::size_t;
-    using event_registry_ptr = std::unique_ptr<detail::_event_registry>;
-    std::vector<std::pair<event_registry_id, std::optional<event_registry_ptr>>> registries_;
-    size_t size_;
+    using event_registry_ptr = pmr_ptr<detail::_event_registry>;
+    // Indexed by type_index<event_handler>, so finding an event's registry is
+    // a bounds check and a load. Slots for event types this handler has never
+    // seen are null.
+    std::pmr::vector<event_registry_ptr> registries_;
+    size_t size_ = 0;
+    std::pmr::vector<detail::_event_registry*> queued_registries_;
+    std::pmr::vector<detail::_event_registry*> coalesced_registries_;
 
-    inline event_registry_id _generate_next_event_registry_id() noexcept {
-        static event_registry_id _id = 0;
-        return _id++;
+    static void _track(std::pmr::vector<detail::_event_registry*>& registries,
+                       detail::_event_registry* reg) {
+        if (std::find(registries.begin(), registries.end(), reg) == registries.end()) {
+            registries.push_back(reg);
+        }
     }
 
-    template <typename T>
-    event_registry_id _get_event_registry_id() {
-        static const event_registry_id id = _generate_next_event_registry_id();
-        return id;
+    template <typename E>
+    event_callback_registry<E>* _make_registry() {
+        auto id = detail::type_index<event_handler>::of<E>();
+        if (id >= registries_.size()) {
+            registries_.resize(std::max(id + 1, detail::type_index<event_handler>::count()));
+        }
+
+        auto resource = registries_.get_allocator().resource();
+        auto reg = make_pmr_unique<event_callback_registry<E>>(resource, resource);
+        auto ptr = reg.get();
+        registries_[id] = std::move(reg);
+        ++size_;
+        return ptr;
     }
 
     template <typename T>
     event_callback_registry<T>* _get_registry() {
-        auto id = _get_event_registry_id<T>();
-        auto pos = std::lower_bound(
-            registries_.begin(), registries_.end(), id,
-            [](const auto& a, const auto& b) { return a.first < b; });
-        if (pos == registries_.end() || pos->first != id || !pos->second) {
+        auto id = detail::type_index<event_handler>::of<T>();
+        if (id >= registries_.size()) {
             return nullptr;
         }
-
-        return static_cast<event_callback_registry<T>*>(
-            pos->second.value().get());
+        return static_cast<event_callback_registry<T>*>(registries_[id].get());
     }
 };
 
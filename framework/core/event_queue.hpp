@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace nsc {
+
+// A bounded, lock-free queue that any number of threads may push events into
+// and a single thread (the UI thread) drains. Pushing never blocks and never
+// allocates: when the queue is full, try_push returns false and the event is
+// dropped, so a flood from a background worker cannot stall anyone.
+//
+// Each cell carries a sequence number that tells producers and the consumer
+// whose turn it is, so the only contended operation is the CAS on the
+// enqueue position.
+template <typename E>
+class event_queue {
+   public:
+    // capacity is rounded up to a power of two.
+    explicit event_queue(std::size_t capacity,
+                         std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : cells_(_round_up(capacity), resource), mask_(cells_.size() - 1) {
+        for (std::size_t i = 0; i < cells_.size(); ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    event_queue(const event_queue&) = delete;
+    event_queue& operator=(const event_queue&) = delete;
+
+    std::size_t capacity() const noexcept { return cells_.size(); }
+
+    // Safe to call from any thread.
+    bool try_push(E e) {
+        auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+        cell* target;
+        while (true) {
+            target = &cells_[pos & mask_];
+            auto sequence = target->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        target->value = std::move(e);
+        target->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. Calls f(const E&) for each queued event in push
+    // order and returns how many there were. Stops after one queue's worth,
+    // so producers that keep pushing cannot keep the consumer here forever.
+    template <typename F>
+    std::size_t drain(F&& f) {
+        std::size_t count = 0;
+        while (count < cells_.size()) {
+            auto& source = cells_[dequeue_pos_ & mask_];
+            auto sequence = source.sequence.load(std::memory_order_acquire);
+            if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(dequeue_pos_ + 1) < 0) {
+                break;
+            }
+
+            E e = std::move(source.value);
+            source.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+            ++dequeue_pos_;
+            ++count;
+            f(static_cast<const E&>(e));
+        }
+        return count;
+    }
+
+   private:
+    struct cell {
+        std::atomic<std::size_t> sequence;
+        E value{};
+    };
+
+    static std::size_t _round_up(std::size_t n) noexcept {
+        std::size_t capacity = 2;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    std::pmr::vector<cell> cells_;
+    std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_ = 0;
+    alignas(64) std::size_t dequeue_pos_ = 0;
+};
+
+}  // namespace nsc
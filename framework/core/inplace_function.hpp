@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace nsc {
+
+template <typename Signature, std::size_t Capacity = 48>
+class inplace_function;
+
+// A move-only callable wrapper that keeps callables of up to Capacity bytes
+// inside the object itself, so subscribing a lambda that captures a few
+// pointers or a small struct never touches the heap. Larger callables still
+// work but are boxed on the heap, like std::function would.
+//
+// Calls go through one function pointer that is stamped out for the exact
+// callable type, which the compiler can see through far more often than a
+// std::function's virtual dispatch.
+template <typename R, typename... Args, std::size_t Capacity>
+class inplace_function<R(Args...), Capacity> {
+   public:
+    static constexpr std::size_t capacity = Capacity;
+
+    inplace_function() noexcept = default;
+
+    template <typename F, typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Fn, inplace_function> &&
+                                          std::is_invocable_r_v<R, Fn&, Args...>>>
+    inplace_function(F&& f) {
+        if constexpr (_fits<Fn>()) {
+            ::new (static_cast<void*>(&storage_)) Fn(std::forward<F>(f));
+            invoke_ = &_invoke_inline<Fn>;
+            manage_ = &_manage_inline<Fn>;
+        } else {
+            ::new (static_cast<void*>(&storage_)) Fn*(new Fn(std::forward<F>(f)));
+            invoke_ = &_invoke_boxed<Fn>;
+            manage_ = &_manage_boxed<Fn>;
+        }
+    }
+
+    inplace_function(inplace_function&& other) noexcept { _take(other); }
+
+    inplace_function& operator=(inplace_function&& other) noexcept {
+        if (this != &other) {
+            reset();
+            _take(other);
+        }
+        return *this;
+    }
+
+    inplace_function(const inplace_function&) = delete;
+    inplace_function& operator=(const inplace_function&) = delete;
+
+    ~inplace_function() { reset(); }
+
+    void reset() noexcept {
+        if (manage_) {
+            manage_(&storage_, nullptr);
+            invoke_ = nullptr;
+            manage_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const noexcept { return invoke_ != nullptr; }
+
+    R operator()(Args... args) const {
+        return invoke_(&storage_, std::forward<Args>(args)...);
+    }
+
+    // Whether a callable of type F would be stored without a heap allocation.
+    template <typename F>
+    static constexpr bool stored_inline() noexcept {
+        return _fits<std::decay_t<F>>();
+    }
+
+   private:
+    using invoke_fn = R (*)(void*, Args&&...);
+    // Moves the callable from source into the empty storage at target, or
+    // destroys it if target is null.
+    using manage_fn = void (*)(void* source, void* target);
+
+    template <typename Fn>
+    static constexpr bool _fits() noexcept {
+        return sizeof(Fn) <= Capacity && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template <typename Fn>
+    static R _invoke_inline(void* storage, Args&&... args) {
+        return (*std::launder(static_cast<Fn*>(storage)))(std::forward<Args>(args)...);
+    }
+
+    template <typename Fn>
+    static void _manage_inline(void* source, void* target) {
+        auto f = std::launder(static_cast<Fn*>(source));
+        if (target) {
+            ::new (target) Fn(std::move(*f));
+        }
+        f->~Fn();
+    }
+
+    template <typename Fn>
+    static R _invoke_boxed(void* storage, Args&&... args) {
+        return (**static_cast<Fn**>(storage))(std::forward<Args>(args)...);
+    }
+
+    template <typename Fn>
+    static void _manage_boxed(void* source, void* target) {
+        auto f = *static_cast<Fn**>(source);
+        if (target) {
+            ::new (target) Fn*(f);
+        } else {
+            delete f;
+        }
+    }
+
+    void _take(inplace_function& other) noexcept {
+        if (other.manage_) {
+            other.manage_(&other.storage_, &storage_);
+            invoke_ = other.invoke_;
+            manage_ = other.manage_;
+            other.invoke_ = nullptr;
+            other.manage_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) mutable std::byte storage_[Capacity < sizeof(void*) ? sizeof(void*) : Capacity];
+    invoke_fn invoke_ = nullptr;
+    manage_fn manage_ = nullptr;
+};
+
+}  // namespace nsc
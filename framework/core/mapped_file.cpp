@@ -0,0 +1,116 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nsc {
+
+#ifdef _WIN32
+
+bool mapped_file::open(const std::string& path) {
+    close();
+
+    auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    file_ = file;
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    is_open_ = true;
+    if (size_ == 0) {
+        return true;
+    }
+
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+        close();
+        return false;
+    }
+
+    data_ = static_cast<const std::byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void mapped_file::close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_) {
+        CloseHandle(file_);
+    }
+
+    data_ = nullptr;
+    mapping_ = nullptr;
+    file_ = nullptr;
+    size_ = 0;
+    is_open_ = false;
+}
+
+#else
+
+bool mapped_file::open(const std::string& path) {
+    close();
+
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        auto data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const std::byte*>(data);
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+    is_open_ = true;
+    return true;
+}
+
+void mapped_file::close() {
+    if (data_) {
+        munmap(const_cast<std::byte*>(data_), size_);
+    }
+
+    data_ = nullptr;
+    size_ = 0;
+    is_open_ = false;
+}
+
+#endif
+
+}  // namespace nsc
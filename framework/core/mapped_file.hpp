@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace nsc {
+
+// A read-only memory mapping of a whole file. Pages are read in by the OS as
+// they are touched, so opening a large file costs nothing up front.
+class mapped_file {
+   public:
+    mapped_file() = default;
+    explicit mapped_file(const std::string& path) { open(path); }
+    ~mapped_file() { close(); }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    // Returns false if the file cannot be opened or mapped. An empty file
+    // opens fine and maps to nothing.
+    bool open(const std::string& path);
+    void close();
+
+    bool is_open() const noexcept { return is_open_; }
+    const std::byte* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+
+   private:
+    const std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool is_open_ = false;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+}  // namespace nsc
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace nsc {
+
+// Frees an object made by make_pmr_unique through the resource it came
+// from. It remembers the size of the allocated type, so a pmr_ptr<Base> can
+// own a Derived.
+struct pmr_deleter {
+    std::pmr::memory_resource* resource = nullptr;
+    std::size_t size = 0;
+    std::size_t alignment = 0;
+
+    template <typename T>
+    void operator()(T* p) const {
+        void* block = p;
+        if constexpr (std::is_polymorphic_v<T>) {
+            block = dynamic_cast<void*>(p);
+        }
+        p->~T();
+        resource->deallocate(block, size, alignment);
+    }
+};
+
+template <typename T>
+using pmr_ptr = std::unique_ptr<T, pmr_deleter>;
+
+template <typename T, typename... Args>
+pmr_ptr<T> make_pmr_unique(std::pmr::memory_resource* resource, Args&&... args) {
+    void* block = resource->allocate(sizeof(T), alignof(T));
+    try {
+        auto p = ::new (block) T(std::forward<Args>(args)...);
+        return pmr_ptr<T>(p, pmr_deleter{resource, sizeof(T), alignof(T)});
+    } catch (...) {
+        resource->deallocate(block, sizeof(T), alignof(T));
+        throw;
+    }
+}
+
+// Passes everything through to upstream and counts it, so the heap traffic
+// of building or tearing down a scene can be measured.
+class counting_resource : public std::pmr::memory_resource {
+   public:
+    explicit counting_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : upstream_(upstream) {}
+
+    std::size_t allocations() const noexcept { return allocations_; }
+    std::size_t deallocations() const noexcept { return deallocations_; }
+    std::size_t bytes_allocated() const noexcept { return bytes_allocated_; }
+    std::size_t bytes_in_use() const noexcept { return bytes_in_use_; }
+    std::size_t peak_bytes_in_use() const noexcept { return peak_bytes_in_use_; }
+
+    void reset_counters() noexcept {
+        allocations_ = 0;
+        deallocations_ = 0;
+        bytes_allocated_ = 0;
+        peak_bytes_in_use_ = bytes_in_use_;
+    }
+
+   private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        auto p = upstream_->allocate(bytes, alignment);
+        ++allocations_;
+        bytes_allocated_ += bytes;
+        bytes_in_use_ += bytes;
+        if (bytes_in_use_ > peak_bytes_in_use_) {
+            peak_bytes_in_use_ = bytes_in_use_;
+        }
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        upstream_->deallocate(p, bytes, alignment);
+        ++deallocations_;
+        bytes_in_use_ -= bytes;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* upstream_;
+    std::size_t allocations_ = 0;
+    std::size_t deallocations_ = 0;
+    std::size_t bytes_allocated_ = 0;
+    std::size_t bytes_in_use_ = 0;
+    std::size_t peak_bytes_in_use_ = 0;
+};
+
+// Grows in large blocks and frees nothing until it is destroyed.
+using monotonic_arena = std::pmr::monotonic_buffer_resource;
+
+// Recycles freed blocks in per-size pools. Single-threaded.
+using pool_resource = std::pmr::unsynchronized_pool_resource;
+
+// Memory for one scene: a pool on top of a monotonic arena. Blocks freed
+// while the scene churns (groups growing, callbacks coming and going) are
+// reused through the pool, and the whole scene goes back to upstream in one
+// step when the arena is destroyed or release() is called. Everything
+// allocated from it must be destroyed before that.
+class scene_arena {
+   public:
+    explicit scene_arena(std::size_t initial_size = 64 * 1024,
+                         std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : arena_(initial_size, upstream), pool_(&arena_) {}
+
+    scene_arena(const scene_arena&) = delete;
+    scene_arena& operator=(const scene_arena&) = delete;
+
+    std::pmr::memory_resource* resource() noexcept { return &pool_; }
+
+    void release() {
+        pool_.release();
+        arena_.release();
+    }
+
+   private:
+    monotonic_arena arena_;
+    pool_resource pool_;
+};
+
+}  // namespace nsc
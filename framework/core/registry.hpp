@@ -1,180 +1,661 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <iterator>
+#include <limits>
 #include <memory>
-#include <optional>
+#include <memory_resource>
+#include <span>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
 
+#include "memory.hpp"
+#include "thread_pool.hpp"
+#include "type_index.hpp"
+
 namespace nsc {
-using obj_handle = int;
+// Handles pack a slot index in the low 32 bits and the slot's generation in
+// the high 32 bits. Removing an object bumps the generation of its slot, so a
+// handle that outlives its object never resolves to whatever reuses the slot.
+using obj_handle = std::uint64_t;
 using group_handle = std::size_t;
 
+inline constexpr obj_handle null_handle = std::numeric_limits<obj_handle>::max();
+
 namespace detail {
 
+class handle_pool;
+
 struct _registry_object {
+    virtual ~_registry_object() = default;
+
+    virtual bool contains(obj_handle handle) const noexcept = 0;
+    virtual void remove(const obj_handle& handle) = 0;
+    virtual void clear_changes() = 0;
+
+    // Used to copy a registry group by group into a snapshot.
+    virtual std::uint64_t version() const noexcept = 0;
+    virtual pmr_ptr<_registry_object> clone(handle_pool* pool, std::pmr::memory_resource* resource) const = 0;
+    virtual void assign(const _registry_object& other) = 0;
 };
 
-template <typename Handle, typename T>
-struct pair {
-    Handle handle;
-    std::optional<T> value;
+inline constexpr std::uint32_t handle_index(obj_handle handle) noexcept {
+    return static_cast<std::uint32_t>(handle);
+}
+
+inline constexpr std::uint32_t handle_generation(obj_handle handle) noexcept {
+    return static_cast<std::uint32_t>(handle >> 32);
+}
+
+inline constexpr obj_handle make_handle(std::uint32_t index, std::uint32_t generation) noexcept {
+    return (static_cast<obj_handle>(generation) << 32) | index;
+}
+
+// Hands out generational handles and recycles the slots of released ones.
+class handle_pool {
+   public:
+    explicit handle_pool(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : generations_(resource), free_(resource) {}
+
+    obj_handle create() {
+        ++version_;
+        if (!free_.empty()) {
+            auto index = free_.back();
+            free_.pop_back();
+            return make_handle(index, generations_[index]);
+        }
+
+        auto index = static_cast<std::uint32_t>(generations_.size());
+        generations_.push_back(0);
+        return make_handle(index, 0);
+    }
+
+    void release(obj_handle handle) {
+        ++version_;
+        auto index = handle_index(handle);
+        ++generations_[index];
+        free_.push_back(index);
+    }
+
+    void reserve(std::size_t n) {
+        generations_.reserve(n);
+    }
+
+    bool is_alive(obj_handle handle) const noexcept {
+        auto index = handle_index(handle);
+        return index < generations_.size() && generations_[index] == handle_generation(handle);
+    }
+
+    // Moves on every create() and release().
+    std::uint64_t version() const noexcept { return version_; }
+
+    // The whole state of the pool, for saving and restoring it.
+    const std::pmr::vector<std::uint32_t>& generations() const noexcept { return generations_; }
+    const std::pmr::vector<std::uint32_t>& free_slots() const noexcept { return free_; }
+
+    void restore(std::span<const std::uint32_t> generations, std::span<const std::uint32_t> free_slots) {
+        ++version_;
+        generations_.assign(generations.begin(), generations.end());
+        free_.assign(free_slots.begin(), free_slots.end());
+    }
+
+   private:
+    std::pmr::vector<std::uint32_t> generations_;
+    std::pmr::vector<std::uint32_t> free_;
+    std::uint64_t version_ = 0;
 };
 
+// Chunk size for splitting n dense Ts across a pool: roughly four chunks per
+// thread so stealing can even out the load, never tiny, and a whole number
+// of cache lines so neighbouring chunks do not write to the same line.
+template <typename T>
+std::size_t parallel_grain(std::size_t n, std::size_t workers) noexcept {
+    constexpr std::size_t cache_line = 64;
+    constexpr std::size_t per_line = sizeof(T) >= cache_line ? 1 : cache_line / sizeof(T);
+    constexpr std::size_t min_grain = 256;
+
+    auto grain = std::max(n / ((workers + 1) * 4), min_grain);
+    return (grain + per_line - 1) / per_line * per_line;
+}
+
 }  // namespace detail
 
+// packed: remove() swaps the last object into the hole. O(1), but the
+//         iteration order of the moved object changes.
+// ordered: remove() shifts the tail down. O(n), keeps insertion order, which
+//         matters for types whose iteration order is their draw order.
+// Either way the values stay contiguous and iteration never skips holes.
+enum class storage_mode {
+    packed,
+    ordered,
+};
+
+template <typename T>
+struct group_traits {
+    static constexpr storage_mode mode = storage_mode::packed;
+};
+
 template <typename T>
 class group : public detail::_registry_object {
-    using obj_pair = detail::pair<obj_handle, T>;
+    using dense_index = std::uint32_t;
+    static constexpr dense_index npos = std::numeric_limits<dense_index>::max();
 
    public:
-    class iterator final {
-       public:
-        using It = typename std::vector<obj_pair>::iterator;
-        using value_type = T;
-        using reference = T&;
-        using pointer = T*;
-        using difference_type = std::ptrdiff_t;
-        using iterator_category = std::forward_iterator_tag;
+    using iterator = typename std::pmr::vector<T>::iterator;
+    using const_iterator = typename std::pmr::vector<T>::const_iterator;
+
+    // A standalone group hands out its own handles. A group that shares a
+    // pool (as every group of a registry does) lets one handle carry several
+    // components, and leaves releasing the handle to the pool's owner.
+    //
+    // Every array of the group is allocated from resource.
+    explicit group(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : group(nullptr, resource) {}
+    group(detail::handle_pool* pool, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : pool_{pool},
+          sparse_(resource),
+          handles_(resource),
+          values_(resource),
+          change_flags_(resource),
+          created_(resource),
+          updated_(resource),
+          removed_(resource) {
+        if (!pool_) {
+            owned_pool_ = make_pmr_unique<detail::handle_pool>(resource, resource);
+            pool_ = owned_pool_.get();
+        }
+    }
 
-        iterator(It from, It to) noexcept {
-            it = from;
-            end = to;
-            if (it != end && !it->value) {
-                ++(*this);
-            }
+    // Every non-const way into the values (begin, data, get) may be used to
+    // write, so each one moves version() and the group is copied on the
+    // next snapshot sync. Only get_mut, patch and attach also report the
+    // object in updated().
+    iterator begin() {
+        ++version_;
+        return values_.begin();
+    }
+    iterator end() { return values_.end(); }
+
+    const_iterator begin() const { return values_.begin(); }
+    const_iterator end() const { return values_.end(); }
+
+    template <typename... Args>
+    obj_handle emplace(Args&&... args) {
+        return _insert(T{std::forward<Args>(args)...});
+    }
+
+    obj_handle push_back(const T& t) {
+        return _insert(t);
+    }
+
+    obj_handle push_back(T&& t) {
+        return _insert(std::move(t));
+    }
+
+    // Makes room for n objects in total, so building a screen of n descs
+    // does not reallocate along the way.
+    void reserve(std::size_t n) {
+        values_.reserve(n);
+        handles_.reserve(n);
+        sparse_.reserve(n);
+        change_flags_.reserve(n);
+        pool_->reserve(n);
+    }
+
+    // Inserts one object per element of [first, last), each constructed from
+    // the element. Returns the new handles in the same order.
+    template <typename It>
+    std::vector<obj_handle> emplace_range(It first, It last) {
+        std::vector<obj_handle> created;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                        typename std::iterator_traits<It>::iterator_category>) {
+            auto n = static_cast<std::size_t>(std::distance(first, last));
+            reserve(values_.size() + n);
+            created.reserve(n);
         }
 
-        iterator& operator++() {
-            while (++it != end && !it->value) {
-            }
-            return *this;
+        for (; first != last; ++first) {
+            created.push_back(_insert(T{*first}));
         }
+        return created;
+    }
 
-        iterator& operator++(int) {
-            auto temp = *this;
-            ++*this;
-            return temp;
+    // Inserts n objects, each constructed from args.
+    template <typename... Args>
+    std::vector<obj_handle> create_n(std::size_t n, const Args&... args) {
+        reserve(values_.size() + n);
+        std::vector<obj_handle> created;
+        created.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            created.push_back(_insert(T{args...}));
         }
+        return created;
+    }
 
-        bool operator==(const iterator& other) const noexcept { return other.it == it; }
-        bool operator!=(const iterator& other) const noexcept { return !(*this == other); }
+    // Adds a T to an object that already has a handle from this group's
+    // pool. Replaces the existing T if the object already has one.
+    template <typename... Args>
+    T* attach(const obj_handle& handle, Args&&... args) {
+        if (auto pos = _find(handle); pos != npos) {
+            values_[pos] = T{std::forward<Args>(args)...};
+            _mark(handle, _updated);
+            return &values_[pos];
+        }
 
-        reference operator*() { return *it->value; }
-        pointer operator->() { return &*it->value; }
+        _insert_at(handle, T{std::forward<Args>(args)...});
+        return &values_.back();
+    }
 
-       private:
-        It it;
-        It end;
-    };
+    bool contains(obj_handle handle) const noexcept override {
+        return _find(handle) != npos;
+    }
 
-    class const_iterator final {
-       public:
-        using It = typename std::vector<obj_pair>::const_iterator;
-        using value_type = T;
-        using reference = const T&;
-        using pointer = const T*;
-        using difference_type = std::ptrdiff_t;
-        using iterator_category = std::forward_iterator_tag;
+    // Like get(), but records the object as updated for change tracking.
+    T* get_mut(const obj_handle& handle) {
+        auto pos = _find(handle);
+        if (pos == npos) {
+            return nullptr;
+        }
 
-        const_iterator(It from, It to) noexcept : it{from}, end{to} {
-            if (it != end && !it->value) {
-                ++(*this);
+        _mark(handle, _updated);
+        return &values_[pos];
+    }
+
+    // Runs f(T&) on the object and records it as updated. Returns false if
+    // the handle is stale.
+    template <typename F>
+    bool patch(const obj_handle& handle, F&& f) {
+        auto value = get_mut(handle);
+        if (!value) {
+            return false;
+        }
+
+        f(*value);
+        return true;
+    }
+
+    T* get(const obj_handle& handle) {
+        auto value = _lookup(handle);
+        if (value) {
+            ++version_;
+        }
+        return value;
+    }
+
+    const T* get(const obj_handle& handle) const {
+        auto pos = _find(handle);
+        return pos == npos ? nullptr : &values_[pos];
+    }
+
+    void remove(const obj_handle& handle) override {
+        auto pos = _find(handle);
+        if (pos == npos) {
+            return;
+        }
+
+        _unlink(handle);
+        if constexpr (group_traits<T>::mode == storage_mode::packed) {
+            _swap_remove(pos);
+        } else {
+            _ordered_remove(pos);
+        }
+    }
+
+    // Replaces the contents of the group with handles[i] -> *(values + i),
+    // e.g. to load a saved group in one go. The handles must be alive in the
+    // group's pool. Everything loaded is reported as created.
+    template <typename It>
+    void restore(std::span<const obj_handle> handles, It values) {
+        ++version_;
+        clear_changes();
+        std::fill(sparse_.begin(), sparse_.end(), npos);
+        handles_.assign(handles.begin(), handles.end());
+        values_.assign(values, values + handles.size());
+
+        for (dense_index pos = 0; pos < handles_.size(); ++pos) {
+            auto index = detail::handle_index(handles_[pos]);
+            if (index >= sparse_.size()) {
+                sparse_.resize(index + 1, npos);
+                change_flags_.resize(index + 1, 0);
+            }
+            sparse_[index] = pos;
+            change_flags_[index] = _created;
+        }
+        created_.assign(handles_.begin(), handles_.end());
+    }
+
+    // Removes every live handle in handles. Stale handles are ignored. An
+    // ordered group closes all the holes in one pass over its values instead
+    // of shifting the tail once per handle.
+    void remove(std::span<const obj_handle> handles) {
+        if constexpr (group_traits<T>::mode == storage_mode::packed) {
+            for (const auto& handle : handles) {
+                remove(handle);
+            }
+        } else {
+            bool any = false;
+            for (const auto& handle : handles) {
+                if (_find(handle) != npos) {
+                    _unlink(handle);
+                    any = true;
+                }
+            }
+
+            if (any) {
+                _compact();
             }
         }
+    }
 
-        const_iterator& operator++() {
-            while (++it != end && !it->value) {
+    // Calls f(T&) for every object, spread over pool. f runs concurrently on
+    // several threads and must not add or remove objects.
+    template <typename F>
+    void parallel_for_each(thread_pool& pool, F&& f) {
+        auto values = data();
+        auto grain = detail::parallel_grain<T>(values_.size(), pool.size());
+        pool.parallel_for(values_.size(), grain, [values, &f](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                f(values[i]);
             }
-            return *this;
+        });
+    }
+
+    size_t size() const noexcept { return values_.size(); }
+    bool empty() const noexcept { return values_.empty(); }
+
+    // The dense arrays, in iteration order. handles()[i] owns data()[i].
+    T* data() noexcept {
+        ++version_;
+        return values_.data();
+    }
+    const T* data() const noexcept { return values_.data(); }
+    const std::pmr::vector<obj_handle>& handles() const noexcept { return handles_; }
+
+    // Handles created, updated (through get_mut, patch or attach) and
+    // removed since the last clear_changes(). Each handle appears at most
+    // once per list. An object created and removed within the same frame
+    // shows up in both created() and removed(), and get() on it is nullptr.
+    // Writes through plain get() move version() but are not listed here.
+    const std::pmr::vector<obj_handle>& created() const noexcept { return created_; }
+    const std::pmr::vector<obj_handle>& updated() const noexcept { return updated_; }
+    const std::pmr::vector<obj_handle>& removed() const noexcept { return removed_; }
+
+    bool has_changes() const noexcept {
+        return !created_.empty() || !updated_.empty() || !removed_.empty();
+    }
+
+    void clear_changes() override {
+        for (auto handle : created_) {
+            change_flags_[detail::handle_index(handle)] = 0;
+        }
+        for (auto handle : updated_) {
+            change_flags_[detail::handle_index(handle)] = 0;
         }
 
-        const_iterator& operator++(int) {
-            auto temp = *this;
-            ++*this;
-            return temp;
+        created_.clear();
+        updated_.clear();
+        removed_.clear();
+    }
+
+    // Moves on every insert, remove, tracked update and non-const access, so
+    // any write reaches snapshots.
+    std::uint64_t version() const noexcept override { return version_; }
+
+    // Groups of move-only types are left out of snapshots: clone() returns
+    // nullptr for them.
+    pmr_ptr<detail::_registry_object> clone(detail::handle_pool* pool, std::pmr::memory_resource* resource) const override {
+        if constexpr (std::is_copy_assignable_v<T>) {
+            auto copy = make_pmr_unique<group<T>>(resource, pool, resource);
+            copy->assign(*this);
+            return copy;
+        } else {
+            return nullptr;
         }
+    }
 
-        bool operator==(const const_iterator& other) const noexcept { return other.it == it; }
-        bool operator!=(const const_iterator& other) const noexcept { return !(*this == other); }
+    // Copies the objects of other, but not its pool or pending changes.
+    void assign(const detail::_registry_object& other) override {
+        if constexpr (std::is_copy_assignable_v<T>) {
+            const auto& source = static_cast<const group<T>&>(other);
+            sparse_ = source.sparse_;
+            handles_ = source.handles_;
+            values_ = source.values_;
+            change_flags_.assign(sparse_.size(), 0);
+            created_.clear();
+            updated_.clear();
+            removed_.clear();
+            version_ = source.version_;
+        }
+    }
 
-        reference operator*() { return *it->value; }
-        pointer operator->() { return &*it->value; }
+   private:
+    // Views move version_ once up front instead, as parallel_each looks
+    // objects up from several threads at once.
+    template <typename...>
+    friend class view;
+
+    T* _lookup(const obj_handle& handle) {
+        auto pos = _find(handle);
+        return pos == npos ? nullptr : &values_[pos];
+    }
 
-       private:
-        It it;
-        It end;
+    void _touch() noexcept { ++version_; }
+
+    enum change_flag : std::uint8_t {
+        _created = 1 << 0,
+        _updated = 1 << 1,
     };
 
-    iterator begin() { return {registry_.begin(), registry_.end()}; }
-    iterator end() { return {registry_.end(), registry_.end()}; }
+    obj_handle _insert(T&& t) {
+        auto handle = pool_->create();
+        _insert_at(handle, std::move(t));
+        return handle;
+    }
 
-    const_iterator begin() const { return {registry_.begin(), registry_.end()}; }
-    const_iterator end() const { return {registry_.end(), registry_.end()}; }
+    void _insert_at(obj_handle handle, T&& t) {
+        auto index = detail::handle_index(handle);
+        if (index >= sparse_.size()) {
+            sparse_.resize(index + 1, npos);
+            change_flags_.resize(index + 1, 0);
+        }
 
-    template <typename... Args>
-    obj_handle emplace(Args... args) {
-        auto handle = _generate_next_obj_id();
-        registry_.emplace_back(obj_pair{handle, T{std::forward<Args>(args)...}});
-        ++size_;
-        return handle;
+        sparse_[index] = static_cast<dense_index>(values_.size());
+        handles_.push_back(handle);
+        values_.emplace_back(std::move(t));
+        _mark(handle, _created);
     }
 
-    obj_handle push_back(const T& t) {
-        auto handle = _generate_next_obj_id();
-        registry_.push_back(obj_pair{handle, t});
-        ++size_;
-        return handle;
+    // An object created this frame is reported as created only, not also as
+    // updated.
+    void _mark(obj_handle handle, change_flag flag) {
+        ++version_;
+        auto& flags = change_flags_[detail::handle_index(handle)];
+        if (flags & (_created | flag)) {
+            return;
+        }
+
+        flags |= flag;
+        (flag == _created ? created_ : updated_).push_back(handle);
     }
 
-    T* get(const obj_handle& handle) {
-        auto pos = std::lower_bound(registry_.begin(),
-                                    registry_.end(),
-                                    handle,
-                                    [](const auto& a, const auto& b) { return a.handle < b; });
+    obj_handle _insert(const T& t) {
+        return _insert(T{t});
+    }
 
-        if (pos == registry_.end() || pos->handle != handle || !pos->value) {
-            return nullptr;
+    dense_index _find(const obj_handle& handle) const noexcept {
+        auto index = detail::handle_index(handle);
+        if (index >= sparse_.size()) {
+            return npos;
+        }
+
+        auto pos = sparse_[index];
+        if (pos == npos || handles_[pos] != handle) {
+            return npos;
+        }
+
+        return pos;
+    }
+
+    // Moves the last object into the hole.
+    void _swap_remove(dense_index pos) {
+        auto last = static_cast<dense_index>(values_.size() - 1);
+        if (pos != last) {
+            values_[pos] = std::move(values_[last]);
+            handles_[pos] = handles_[last];
+            sparse_[detail::handle_index(handles_[pos])] = pos;
+        }
+
+        values_.pop_back();
+        handles_.pop_back();
+    }
+
+    // Clears the sparse entry and change flags of a live handle, which is
+    // what marks it as removed. The dense slot is left to the caller.
+    void _unlink(const obj_handle& handle) {
+        ++version_;
+        sparse_[detail::handle_index(handle)] = npos;
+        change_flags_[detail::handle_index(handle)] = 0;
+        removed_.push_back(handle);
+        if (owned_pool_) {
+            pool_->release(handle);
+        }
+    }
+
+    // Shifts everything after the hole down by one so insertion order is
+    // kept, then repoints the sparse entries of the objects that moved.
+    void _ordered_remove(dense_index pos) {
+        values_.erase(values_.begin() + pos);
+        handles_.erase(handles_.begin() + pos);
+        for (auto i = pos; i < handles_.size(); ++i) {
+            sparse_[detail::handle_index(handles_[i])] = i;
+        }
+    }
+
+    // Drops every dense slot whose handle was unlinked, keeping the order of
+    // the rest, and repoints the sparse entries of the objects that moved.
+    void _compact() {
+        dense_index out = 0;
+        for (dense_index in = 0; in < handles_.size(); ++in) {
+            if (sparse_[detail::handle_index(handles_[in])] != in) {
+                continue;
+            }
+
+            if (in != out) {
+                values_[out] = std::move(values_[in]);
+                handles_[out] = handles_[in];
+                sparse_[detail::handle_index(handles_[out])] = out;
+            }
+            ++out;
         }
 
-        return &(*(pos->value));
+        values_.erase(values_.begin() + out, values_.end());
+        handles_.resize(out);
     }
 
-    void remove(const obj_handle& handle) {
-        auto pos = std::lower_bound(registry_.begin(),
-                                    registry_.end(),
-                                    handle,
-                                    [](const auto& a, const auto& b) { return a.handle < b; });
+    pmr_ptr<detail::handle_pool> owned_pool_;
+    detail::handle_pool* pool_;
+    std::pmr::vector<dense_index> sparse_;
+    std::pmr::vector<obj_handle> handles_;
+    std::pmr::vector<T> values_;
+
+    // Indexed like sparse_.
+    std::pmr::vector<std::uint8_t> change_flags_;
+    std::pmr::vector<obj_handle> created_;
+    std::pmr::vector<obj_handle> updated_;
+    std::pmr::vector<obj_handle> removed_;
+    std::uint64_t version_ = 0;
+};
+
+// Joins several groups on their shared handles. each() walks the handles of
+// the smallest group and probes the others through their sparse index, so a
+// join costs one O(1) lookup per other component and never searches.
+// Adding to or removing from the joined groups inside each() is not allowed.
+template <typename... Ts>
+class view {
+    static_assert(sizeof...(Ts) > 0, "VIEW: A view needs at least one component type");
+
+   public:
+    explicit view(group<Ts>*... groups) : groups_{groups...} {}
 
-        if (pos == registry_.end() || pos->handle != handle) {
+    // Calls f(handle, Ts&...) for every handle that has all of Ts.
+    template <typename F>
+    void each(F&& f) {
+        auto lead = _smallest();
+        if (!lead) {
             return;
         }
+        _touch();
 
-        pos->value.reset();
-        --size_;
+        for (auto handle : *lead) {
+            auto components = std::make_tuple(std::get<group<Ts>*>(groups_)->_lookup(handle)...);
+            if (!(std::get<Ts*>(components) && ...)) {
+                continue;
+            }
 
-        if (size_ < (registry_.size() / 2)) {
-            registry_.erase(std::remove_if(registry_.begin(),
-                                           registry_.end(),
-                                           [](const auto& e) { return !e.value; }));
+            f(handle, *std::get<Ts*>(components)...);
         }
     }
 
+    // Like each(), but spread over pool. f runs concurrently on several
+    // threads and must not add or remove objects in the joined groups.
+    template <typename F>
+    void parallel_each(thread_pool& pool, F&& f) {
+        auto lead = _smallest();
+        if (!lead) {
+            return;
+        }
+        _touch();
+
+        auto grain = detail::parallel_grain<obj_handle>(lead->size(), pool.size());
+        pool.parallel_for(lead->size(), grain, [this, lead, &f](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                auto handle = (*lead)[i];
+                auto components = std::make_tuple(std::get<group<Ts>*>(groups_)->_lookup(handle)...);
+                if (!(std::get<Ts*>(components) && ...)) {
+                    continue;
+                }
+
+                f(handle, *std::get<Ts*>(components)...);
+            }
+        });
+    }
+
    private:
-    inline obj_handle _generate_next_obj_id() noexcept {
-        static obj_handle id_ = 0;
-        return id_++;
+    // f gets every component by reference and may write to any of them.
+    void _touch() noexcept { (std::get<group<Ts>*>(groups_)->_touch(), ...); }
+
+    const std::pmr::vector<obj_handle>* _smallest() const noexcept {
+        if (!(std::get<group<Ts>*>(groups_) && ...)) {
+            return nullptr;
+        }
+
+        const std::pmr::vector<obj_handle>* lead = nullptr;
+        auto consider = [&lead](const auto* g) {
+            if (!lead || g->size() < lead->size()) {
+                lead = &g->handles();
+            }
+        };
+        (consider(std::get<group<Ts>*>(groups_)), ...);
+        return lead;
     }
 
-    size_t size_;
-    std::vector<obj_pair> registry_;
+    std::tuple<group<Ts>*...> groups_;
 };
 
-class registry {
-    using group_pair = detail::pair<group_handle, std::unique_ptr<detail::_registry_object>>;
+class registry_archive;
 
+class registry {
    public:
+    // Groups, their arrays and the handle pool are all allocated from
+    // resource, so a whole scene can live in one scene_arena.
+    explicit registry(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : pool_(resource), groups_(resource), synced_versions_(resource), resource_(resource) {}
+    registry(const registry&) = delete;
+    registry& operator=(const registry&) = delete;
+
     template <typename T, typename... Args>
     obj_handle create(Args&&... args) {
         return make_group<T>()->emplace(std::forward<Args>(args)...);
@@ -185,21 +666,43 @@ class registry {
         static_assert(std::is_member_function_pointer_v<decltype(&Loader::create)>, "CANVAS: Attempted to create a type T with a loader that does not have a <T create(...)> function");
         static_assert(std::is_same<decltype(loader->create(args...)), T>::value, "CANVAS: Attempted to create a type T with a loader whose create(...) method doesn't return T!");
         T obj = loader->create(std::forward<Args>(args)...);
-        return make_group<T>()->push_back(obj);
+        return make_group<T>()->push_back(std::move(obj));
+    }
+
+    template <typename T>
+    void reserve(std::size_t n) {
+        pool_.reserve(n);
+        make_group<T>()->reserve(n);
+    }
+
+    template <typename T, typename It>
+    std::vector<obj_handle> emplace_range(It first, It last) {
+        return make_group<T>()->emplace_range(first, last);
+    }
+
+    template <typename T, typename... Args>
+    std::vector<obj_handle> create_n(std::size_t n, const Args&... args) {
+        return make_group<T>()->create_n(n, args...);
     }
 
     template <typename T>
     group<T>* get_group() {
         auto handle = _get_group_handle<T>();
-        auto pos = std::lower_bound(groups_.begin(),
-                                    groups_.end(),
-                                    handle,
-                                    [](const auto& a, const auto& b) { return a.handle < b; });
-        if (pos == groups_.end() || pos->handle != handle || !pos->value) {
+        if (handle >= groups_.size() || !groups_[handle]) {
             return nullptr;
         }
 
-        return static_cast<group<T>*>(pos->value->get());
+        return static_cast<group<T>*>(groups_[handle].get());
+    }
+
+    template <typename T>
+    const group<T>* get_group() const {
+        auto handle = _get_group_handle<T>();
+        if (handle >= groups_.size() || !groups_[handle]) {
+            return nullptr;
+        }
+
+        return static_cast<const group<T>*>(groups_[handle].get());
     }
 
     template <typename T>
@@ -210,40 +713,174 @@ class registry {
         return nullptr;
     }
 
+    template <typename T>
+    const T* get(obj_handle id) const {
+        if (auto group = get_group<T>(); group) {
+            return group->get(id);
+        }
+        return nullptr;
+    }
+
+    template <typename T>
+    T* get_mut(obj_handle id) {
+        if (auto group = get_group<T>(); group) {
+            return group->get_mut(id);
+        }
+        return nullptr;
+    }
+
+    template <typename T, typename F>
+    bool patch(obj_handle id, F&& f) {
+        if (auto group = get_group<T>(); group) {
+            return group->patch(id, std::forward<F>(f));
+        }
+        return false;
+    }
+
+    // Gives an existing object another component, e.g. layout state next to
+    // its ImageDesc. Returns nullptr if the handle is stale.
+    template <typename T, typename... Args>
+    T* attach(const obj_handle& id, Args&&... args) {
+        if (!pool_.is_alive(id)) {
+            return nullptr;
+        }
+        return make_group<T>()->attach(id, std::forward<Args>(args)...);
+    }
+
+    // Removes the T component of an object. The handle is released once the
+    // object has no components left.
     template <typename T>
     void remove(const obj_handle& id) {
         if (auto group = get_group<T>(); group) {
             group->remove(id);
         }
+
+        if (pool_.is_alive(id) && !_is_referenced(id)) {
+            pool_.release(id);
+        }
     }
 
-   private:
-    inline group_handle _generate_next_group_handle() noexcept {
-        static group_handle _id = 0;
-        return ++_id;
+    template <typename T>
+    void remove(std::span<const obj_handle> ids) {
+        if (auto group = get_group<T>(); group) {
+            group->remove(ids);
+        }
+
+        for (const auto& id : ids) {
+            if (pool_.is_alive(id) && !_is_referenced(id)) {
+                pool_.release(id);
+            }
+        }
+    }
+
+    // Removes every component of an object and releases its handle.
+    void destroy(const obj_handle& id) {
+        if (!pool_.is_alive(id)) {
+            return;
+        }
+
+        for (auto& group : groups_) {
+            if (group) {
+                group->remove(id);
+            }
+        }
+        pool_.release(id);
+    }
+
+    // Ends the frame for change tracking: every group forgets what was
+    // created, updated and removed so far.
+    void clear_changes() {
+        for (auto& group : groups_) {
+            if (group) {
+                group->clear_changes();
+            }
+        }
+    }
+
+    // Makes this registry a copy of source. Only the groups whose version
+    // moved since the last sync_from are copied, so keeping a snapshot up to
+    // date costs as much as the groups that changed.
+    void sync_from(const registry& source) {
+        if (pool_version_ != source.pool_.version()) {
+            pool_ = source.pool_;
+            pool_version_ = source.pool_.version();
+        }
+
+        if (groups_.size() < source.groups_.size()) {
+            groups_.resize(source.groups_.size());
+            synced_versions_.resize(source.groups_.size());
+        }
+
+        for (size_t i = 0; i < source.groups_.size(); ++i) {
+            const auto& from = source.groups_[i];
+            if (!from) {
+                continue;
+            }
+
+            auto& to = groups_[i];
+            if (!to) {
+                to = from->clone(&pool_, resource_);
+            } else if (synced_versions_[i] != from->version()) {
+                to->assign(*from);
+            } else {
+                continue;
+            }
+            synced_versions_[i] = from->version();
+        }
+    }
+
+    template <typename... Ts>
+    nsc::view<Ts...> view() {
+        return nsc::view<Ts...>{get_group<Ts>()...};
     }
 
+    // view<Ts...>().parallel_each(pool, f)
+    template <typename... Ts, typename F>
+    void parallel_view(thread_pool& pool, F&& f) {
+        view<Ts...>().parallel_each(pool, std::forward<F>(f));
+    }
+
+   private:
+    friend class registry_archive;
+
     template <typename T>
-    group_handle _get_group_handle() {
-        static const group_handle id = _generate_next_group_handle();
-        return id;
+    static group_handle _get_group_handle() noexcept {
+        return detail::type_index<registry>::of<T>();
     }
 
     template <typename T>
     group<T>* make_group() {
-        auto existing_group = get_group<T>();
-        if (existing_group) {
-            return existing_group;
+        auto handle = _get_group_handle<T>();
+        if (handle >= groups_.size()) {
+            groups_.resize(handle + 1);
         }
 
-        auto handle = _get_group_handle<T>();
-        auto new_group = std::make_unique<group<T>>();
-        groups_.push_back(group_pair {handle, std::move(new_group)});
-        ++size_;
-        return get_group<T>();
+        if (!groups_[handle]) {
+            groups_[handle] = make_pmr_unique<group<T>>(resource_, &pool_, resource_);
+        }
+
+        return static_cast<group<T>*>(groups_[handle].get());
     }
 
-    size_t size_;
-    std::vector<group_pair> groups_;
+    bool _is_referenced(const obj_handle& id) const noexcept {
+        for (const auto& group : groups_) {
+            if (group && group->contains(id)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Shared by every group so one handle can own components in several.
+    detail::handle_pool pool_;
+    // Indexed directly by group handle; types this registry has never seen
+    // are empty slots.
+    std::pmr::vector<pmr_ptr<detail::_registry_object>> groups_;
+
+    // What this registry last copied from in sync_from.
+    std::uint64_t pool_version_ = 0;
+    std::pmr::vector<std::uint64_t> synced_versions_;
+
+    std::pmr::memory_resource* resource_;
 };
 }  // namespace nsc
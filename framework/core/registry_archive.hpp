@@ -0,0 +1,376 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "archive_traits.hpp"
+#include "asset.hpp"
+#include "mapped_file.hpp"
+#include "registry.hpp"
+
+namespace nsc {
+
+// Saves registry groups to a binary file and restores them in a later run,
+// so a large scene does not have to be rebuilt from code on every launch.
+//
+// Only groups whose archive_traits<T>::stored is trivially copyable can be
+// saved; their values are written as raw bytes, so a file is only readable
+// by builds with the same layout for those types. Every array in the file is
+// 8-byte aligned, so restoring reads straight out of the memory-mapped file
+// with one bulk copy per group. Handles are saved as well and stay valid
+// across the round trip.
+//
+// Pointers to textures and fonts are saved as asset_ids (see archive_traits).
+// The file also carries an asset_table saying where to load each one from:
+//
+//     // saving
+//     nsc::asset_table assets;
+//     textures.export_assets(assets);
+//     nsc::registry_archive::save<ImageDesc>(scene, assets, "scene.nscr");
+//
+//     // restoring
+//     nsc::registry_archive archive;
+//     if (archive.open("scene.nscr")) {
+//         textures.import_assets(archive.assets());
+//         archive.restore<ImageDesc>(scene, textures);
+//     }
+class registry_archive {
+   public:
+    static constexpr std::uint32_t version = 1;
+
+    template <typename... Ts>
+    static bool save(const registry& source, const asset_table& assets, const std::string& path) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+
+        const auto& pool = source.pool_;
+        file_header header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.group_count = static_cast<std::uint32_t>(sizeof...(Ts));
+        header.asset_count = static_cast<std::uint32_t>(assets.entries().size());
+        header.generation_count = pool.generations().size();
+        header.free_count = pool.free_slots().size();
+        _write(out, &header, sizeof(header));
+        _write(out, pool.generations().data(), pool.generations().size() * sizeof(std::uint32_t));
+        _write(out, pool.free_slots().data(), pool.free_slots().size() * sizeof(std::uint32_t));
+        _pad(out);
+
+        for (const auto& [id, entry] : assets.entries()) {
+            asset_record record{id, static_cast<std::uint32_t>(entry.kind), entry.flags, entry.path.size()};
+            _write(out, &record, sizeof(record));
+            _write(out, entry.path.data(), entry.path.size());
+            _pad(out);
+        }
+
+        (_save_group<Ts>(out, source), ...);
+        return static_cast<bool>(out);
+    }
+
+    // Maps the file and reads its header, pool and asset table. Returns false
+    // if the file is missing, truncated or from another format version.
+    bool open(const std::string& path) {
+        groups_.clear();
+        assets_ = asset_table{};
+        if (!file_.open(path)) {
+            return false;
+        }
+
+        cursor_ = 0;
+        file_header header;
+        if (!_read(&header, sizeof(header)) || std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+            header.version != version) {
+            file_.close();
+            return false;
+        }
+
+        generations_ = _take<std::uint32_t>(header.generation_count);
+        free_slots_ = _take<std::uint32_t>(header.free_count);
+        if (generations_.size() != header.generation_count || free_slots_.size() != header.free_count ||
+            !_align() || !_valid_free_slots()) {
+            file_.close();
+            return false;
+        }
+
+        for (std::uint32_t i = 0; i < header.asset_count; ++i) {
+            asset_record record;
+            if (!_read(&record, sizeof(record))) {
+                file_.close();
+                return false;
+            }
+
+            auto path_bytes = _take<std::byte>(record.path_size);
+            if (path_bytes.size() != record.path_size || !_align()) {
+                file_.close();
+                return false;
+            }
+            assets_.add(record.id, static_cast<asset_kind>(record.kind),
+                        std::string(reinterpret_cast<const char*>(path_bytes.data()), path_bytes.size()),
+                        record.flags);
+        }
+
+        for (std::uint32_t i = 0; i < header.group_count; ++i) {
+            group_record record;
+            if (!_read(&record, sizeof(record))) {
+                file_.close();
+                return false;
+            }
+
+            auto handles = _take<obj_handle>(record.count);
+            // count * value_size can overflow, so check it against what is
+            // left by dividing instead.
+            if (handles.size() != record.count ||
+                (record.value_size != 0 && record.count > (file_.size() - cursor_) / record.value_size)) {
+                file_.close();
+                return false;
+            }
+            auto values = _take<std::byte>(record.count * record.value_size);
+            if (values.size() != record.count * record.value_size || !_align()) {
+                file_.close();
+                return false;
+            }
+            groups_[record.key] = saved_group{record.value_size, handles, values.data()};
+        }
+        return true;
+    }
+
+    const asset_table& assets() const noexcept { return assets_; }
+
+    // Loads the saved Ts into target, which must be empty. Groups missing from
+    // the file are left empty. context is handed to archive_traits<T>::
+    // from_stored to turn asset_ids back into pointers.
+    //
+    // Fails without touching target if a saved handle is not alive in the
+    // saved pool or appears twice in a group. Handles that only belonged to
+    // groups not restored here (not saved, or not among Ts) are released, so
+    // their slots are reused instead of leaking.
+    template <typename... Ts, typename Context>
+    bool restore(registry& target, Context& context) {
+        if (!file_.is_open() || !target.pool_.generations().empty()) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> seen;
+        if (!(_valid_group<Ts>(seen) && ...)) {
+            return false;
+        }
+
+        target.pool_.restore(generations_, free_slots_);
+        if (!(_restore_group<Ts>(target, context) && ...)) {
+            return false;
+        }
+
+        std::vector<std::uint8_t> referenced(generations_.size(), 0);
+        for (auto index : free_slots_) {
+            referenced[index] = 1;
+        }
+        (_mark_referenced<Ts>(referenced), ...);
+        for (std::size_t index = 0; index < referenced.size(); ++index) {
+            if (!referenced[index]) {
+                target.pool_.release(detail::make_handle(static_cast<std::uint32_t>(index), generations_[index]));
+            }
+        }
+        return true;
+    }
+
+    template <typename... Ts>
+    bool restore(registry& target) {
+        struct no_context {} context;
+        return restore<Ts...>(target, context);
+    }
+
+   private:
+    static constexpr char magic[4] = {'N', 'S', 'C', 'R'};
+    static constexpr std::size_t alignment = 8;
+
+    struct file_header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t group_count;
+        std::uint32_t asset_count;
+        std::uint64_t generation_count;
+        std::uint64_t free_count;
+    };
+
+    struct asset_record {
+        std::uint64_t id;
+        std::uint32_t kind;
+        std::uint32_t flags;
+        std::uint64_t path_size;
+    };
+
+    struct group_record {
+        std::uint64_t key;
+        std::uint64_t count;
+        std::uint64_t value_size;
+    };
+
+    struct saved_group {
+        std::uint64_t value_size;
+        std::span<const obj_handle> handles;
+        const std::byte* values;
+    };
+
+    template <typename T>
+    static std::uint64_t _key() noexcept {
+        return detail::fnv1a(archive_traits<T>::key);
+    }
+
+    template <typename T>
+    static void _save_group(std::ofstream& out, const registry& source) {
+        using stored = typename archive_traits<T>::stored;
+        static_assert(std::is_trivially_copyable_v<stored>, "ARCHIVE: Only trivially copyable values can be saved");
+        static_assert(alignof(stored) <= alignment, "ARCHIVE: Saved values must not need more than 8-byte alignment");
+
+        auto group = source.get_group<T>();
+        group_record record{_key<T>(), group ? group->size() : 0, sizeof(stored)};
+        _write(out, &record, sizeof(record));
+        if (!group) {
+            return;
+        }
+
+        _write(out, group->handles().data(), group->size() * sizeof(obj_handle));
+        if constexpr (std::is_same_v<stored, T>) {
+            _write(out, group->data(), group->size() * sizeof(T));
+        } else {
+            for (const auto& value : *group) {
+                auto saved = archive_traits<T>::to_stored(value);
+                _write(out, &saved, sizeof(saved));
+            }
+        }
+        _pad(out);
+    }
+
+    // Every slot in the free list exists and is listed once.
+    bool _valid_free_slots() const {
+        std::vector<std::uint8_t> free(generations_.size(), 0);
+        for (auto index : free_slots_) {
+            if (index >= free.size() || free[index]) {
+                return false;
+            }
+            free[index] = 1;
+        }
+        return true;
+    }
+
+    // seen is scratch space, reused across groups.
+    template <typename T>
+    bool _valid_group(std::vector<std::uint8_t>& seen) const {
+        auto it = groups_.find(_key<T>());
+        if (it == groups_.end()) {
+            return true;
+        }
+
+        if (it->second.value_size != sizeof(typename archive_traits<T>::stored)) {
+            return false;
+        }
+
+        seen.assign(generations_.size(), 0);
+        for (auto index : free_slots_) {
+            seen[index] = 1;
+        }
+        for (auto handle : it->second.handles) {
+            auto index = detail::handle_index(handle);
+            if (index >= generations_.size() || generations_[index] != detail::handle_generation(handle) ||
+                seen[index]) {
+                return false;
+            }
+            seen[index] = 1;
+        }
+        return true;
+    }
+
+    template <typename T>
+    void _mark_referenced(std::vector<std::uint8_t>& referenced) const {
+        auto it = groups_.find(_key<T>());
+        if (it == groups_.end()) {
+            return;
+        }
+        for (auto handle : it->second.handles) {
+            referenced[detail::handle_index(handle)] = 1;
+        }
+    }
+
+    template <typename T, typename Context>
+    bool _restore_group(registry& target, Context& context) {
+        using stored = typename archive_traits<T>::stored;
+        auto it = groups_.find(_key<T>());
+        if (it == groups_.end()) {
+            return true;
+        }
+        if (it->second.value_size != sizeof(stored)) {
+            return false;
+        }
+
+        auto group = target.make_group<T>();
+        auto values = reinterpret_cast<const stored*>(it->second.values);
+        if constexpr (std::is_same_v<stored, T>) {
+            group->restore(it->second.handles, values);
+        } else {
+            std::vector<T> converted;
+            converted.reserve(it->second.handles.size());
+            for (std::size_t i = 0; i < it->second.handles.size(); ++i) {
+                converted.push_back(archive_traits<T>::from_stored(values[i], context));
+            }
+            group->restore(it->second.handles, converted.begin());
+        }
+        return true;
+    }
+
+    static void _write(std::ofstream& out, const void* data, std::size_t size) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+
+    static void _pad(std::ofstream& out) {
+        static constexpr char zeros[alignment] = {};
+        auto offset = static_cast<std::size_t>(out.tellp());
+        _write(out, zeros, (alignment - offset % alignment) % alignment);
+    }
+
+    bool _read(void* out, std::size_t size) {
+        if (file_.size() - cursor_ < size) {
+            return false;
+        }
+        std::memcpy(out, file_.data() + cursor_, size);
+        cursor_ += size;
+        return true;
+    }
+
+    // Views count Ts in place, or returns an empty span if the file is too
+    // short.
+    template <typename T>
+    std::span<const T> _take(std::uint64_t count) {
+        if ((file_.size() - cursor_) / sizeof(T) < count) {
+            return {};
+        }
+        auto data = reinterpret_cast<const T*>(file_.data() + cursor_);
+        cursor_ += static_cast<std::size_t>(count) * sizeof(T);
+        return {data, static_cast<std::size_t>(count)};
+    }
+
+    bool _align() {
+        auto padded = (cursor_ + alignment - 1) / alignment * alignment;
+        if (padded > file_.size()) {
+            return false;
+        }
+        cursor_ = padded;
+        return true;
+    }
+
+    mapped_file file_;
+    std::size_t cursor_ = 0;
+    std::span<const std::uint32_t> generations_;
+    std::span<const std::uint32_t> free_slots_;
+    asset_table assets_;
+    std::unordered_map<std::uint64_t, saved_group> groups_;
+};
+
+}  // namespace nsc
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "registry.hpp"
+
+namespace nsc {
+
+// Lets one thread keep mutating a registry while another reads a consistent
+// copy of it, without either side taking a lock.
+//
+// The writer builds its scene in its own live registry and calls publish()
+// once per frame. publish() brings a spare copy up to date with sync_from,
+// which only copies the groups that changed, and hands it over with a single
+// atomic exchange. The reader calls acquire() and gets the newest published
+// copy; that copy is immutable and stays valid until the reader's next
+// acquire(). Three copies are kept so neither side ever waits for the other.
+//
+// Exactly one writer thread and one reader thread may use a buffer.
+class registry_buffer {
+   public:
+    registry_buffer() = default;
+    registry_buffer(const registry_buffer&) = delete;
+    registry_buffer& operator=(const registry_buffer&) = delete;
+
+    // Writer side.
+    void publish(const registry& live) {
+        buffers_[back_].sync_from(live);
+        auto previous = middle_.exchange(back_ | fresh_bit, std::memory_order_acq_rel);
+        back_ = previous & index_mask;
+    }
+
+    // Reader side. Returns the copy published most recently, or the one it
+    // returned last time if nothing new was published since.
+    const registry* acquire() {
+        if (middle_.load(std::memory_order_relaxed) & fresh_bit) {
+            auto previous = middle_.exchange(front_, std::memory_order_acq_rel);
+            front_ = previous & index_mask;
+        }
+        return &buffers_[front_];
+    }
+
+   private:
+    static constexpr std::uint8_t index_mask = 0x3;
+    static constexpr std::uint8_t fresh_bit = 0x4;
+
+    std::array<registry, 3> buffers_;
+    // Owned by the writer.
+    std::uint8_t back_ = 0;
+    // Published and not yet picked up, plus whether it is newer than front_.
+    std::atomic<std::uint8_t> middle_ = 1;
+    // Owned by the reader.
+    std::uint8_t front_ = 2;
+};
+
+}  // namespace nsc
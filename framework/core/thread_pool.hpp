@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace nsc {
+
+// A fixed set of worker threads, each with its own task deque. A worker
+// takes from the back of its own deque and, once that is empty, steals from
+// the front of the others, so uneven chunks even out without a central
+// queue. The thread that calls parallel_for works through chunks too instead
+// of blocking.
+class thread_pool {
+   public:
+    explicit thread_pool(std::size_t workers = default_worker_count()) {
+        for (std::size_t i = 0; i < workers; ++i) {
+            queues_.push_back(std::make_unique<worker_queue>());
+        }
+        for (std::size_t i = 0; i < workers; ++i) {
+            threads_.emplace_back([this, i] { _worker_loop(i); });
+        }
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // One worker per hardware thread, minus the calling thread.
+    static std::size_t default_worker_count() noexcept {
+        auto hardware = std::thread::hardware_concurrency();
+        return hardware > 1 ? hardware - 1 : 0;
+    }
+
+    std::size_t size() const noexcept { return threads_.size(); }
+
+    // Calls f(begin, end) over [0, count) split into chunks of at most grain
+    // items, and returns once every chunk has run. f may run on any thread,
+    // concurrently with itself.
+    template <typename F>
+    void parallel_for(std::size_t count, std::size_t grain, F&& f) {
+        if (count == 0) {
+            return;
+        }
+
+        grain = std::max<std::size_t>(grain, 1);
+        if (threads_.empty() || count <= grain) {
+            f(std::size_t{0}, count);
+            return;
+        }
+
+        auto chunks = (count + grain - 1) / grain;
+        std::atomic<std::size_t> pending = chunks;
+        // F may be a const lvalue reference; the trampoline restores the
+        // constness the void* erased.
+        auto run = [](void* context, std::size_t begin, std::size_t end) {
+            (*static_cast<std::remove_reference_t<F>*>(context))(begin, end);
+        };
+        auto context = const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            auto begin = chunk * grain;
+            auto end = std::min(begin + grain, count);
+            _push(chunk % queues_.size(), task{run, context, begin, end, &pending});
+        }
+
+        // The caller owns no deque, so it only ever steals.
+        while (pending.load(std::memory_order_acquire) != 0) {
+            if (!_run_one(queues_.size())) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+   private:
+    struct task {
+        void (*run)(void*, std::size_t, std::size_t);
+        void* context;
+        std::size_t begin;
+        std::size_t end;
+        std::atomic<std::size_t>* pending;
+    };
+
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    // queued_ is counted before the task becomes visible: a thief that pops
+    // it straight away would otherwise decrement first and wrap the count
+    // around, waking every idle worker to spin on nothing.
+    //
+    // sleep_mutex_ is only taken when a worker may be asleep. The pusher
+    // bumps queued_ and then reads sleepers_; a worker bumps sleepers_ and
+    // then reads queued_. Both are seq_cst, so at least one of them sees
+    // the other's write: either the worker does not sleep, or the pusher
+    // notifies it.
+    void _push(std::size_t queue, const task& t) {
+        queued_.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+            queues_[queue]->tasks.push_back(t);
+        }
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            // Locking orders the notify after a worker that counted itself
+            // but has not started waiting yet.
+            { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+            wake_.notify_one();
+        }
+    }
+
+    bool _try_pop(std::size_t self, task& out) {
+        if (self < queues_.size()) {
+            auto& own = *queues_[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                out = own.tasks.back();
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (std::size_t i = 1; i <= queues_.size(); ++i) {
+            auto& victim = *queues_[(self + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                out = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool _run_one(std::size_t self) {
+        task t;
+        if (!_try_pop(self, t)) {
+            return false;
+        }
+
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        t.run(t.context, t.begin, t.end);
+        t.pending->fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    void _worker_loop(std::size_t self) {
+        while (true) {
+            if (_run_one(self)) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            wake_.wait(lock, [this] { return stop_ || queued_.load(std::memory_order_seq_cst) > 0; });
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            if (stop_) {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<worker_queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    // Tasks pushed but not yet taken, and workers inside wake_.wait. Both
+    // are only hints for when to lock; the deques hold the actual work.
+    std::atomic<std::size_t> queued_ = 0;
+    std::atomic<std::size_t> sleepers_ = 0;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+};
+
+}  // namespace nsc
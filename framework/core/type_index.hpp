@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace nsc::detail {
+
+// Assigns every type a small, dense index the first time it is asked for,
+// counted separately per Family. The index can be used to address a flat
+// per-type table directly, without searching or assuming any ordering.
+template <typename Family>
+class type_index {
+   public:
+    template <typename T>
+    static std::size_t of() noexcept {
+        static const std::size_t id = next_.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    // One past the largest index handed out so far.
+    static std::size_t count() noexcept {
+        return next_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    inline static std::atomic<std::size_t> next_ = 0;
+};
+
+}  // namespace nsc::detail
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace nsc {
+
+inline constexpr std::uint32_t replacement_character = 0xFFFD;
+
+// Decodes the code point that starts at text[pos] and moves pos past it.
+// Malformed input (stray continuation bytes, truncated or overlong
+// sequences, surrogates, values past U+10FFFF) decodes as
+// replacement_character and skips a single byte, so decoding always makes
+// progress and resynchronizes on the next lead byte.
+inline std::uint32_t utf8_next(std::string_view text, std::size_t& pos) noexcept {
+    auto lead = static_cast<unsigned char>(text[pos]);
+    if (lead < 0x80) {
+        ++pos;
+        return lead;
+    }
+
+    std::size_t length;
+    std::uint32_t codepoint;
+    std::uint32_t min;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        codepoint = lead & 0x1F;
+        min = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        codepoint = lead & 0x0F;
+        min = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        codepoint = lead & 0x07;
+        min = 0x10000;
+    } else {
+        ++pos;
+        return replacement_character;
+    }
+
+    if (text.size() - pos < length) {
+        ++pos;
+        return replacement_character;
+    }
+    for (std::size_t i = 1; i < length; ++i) {
+        auto next = static_cast<unsigned char>(text[pos + i]);
+        if ((next & 0xC0) != 0x80) {
+            ++pos;
+            return replacement_character;
+        }
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+
+    if (codepoint < min || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        ++pos;
+        return replacement_character;
+    }
+    pos += length;
+    return codepoint;
+}
+
+}  // namespace nsc
@@ -20,7 +20,7 @@ class Canvas {
 
     template <typename Primitive, typename Loader, typename... Args>
     nsc::obj_handle create_primitive(Loader *loader, Args&&... args) {
-        return primitives.create<Primitive, Loader>(loader, std::forward<Args>(args)...)
+        return primitives.create<Primitive, Loader>(loader, std::forward<Args>(args)...);
     }
 
     template <typename Primitive>
@@ -6,6 +6,8 @@
 #include "../ui/rectangle.hpp"
 #include "font.hpp"
 #include "color.hpp"
+#include "../core/archive_traits.hpp"
+#include "../core/registry.hpp"
 
 struct ImageDesc
 {
@@ -14,6 +16,42 @@ struct ImageDesc
 	nsc::ui::Rectangle bounds;
 };
 
+// Images are drawn in group order and may overlap, so removing one must not
+// reorder the rest.
+namespace nsc {
+template <>
+struct group_traits<ImageDesc>
+{
+	static constexpr storage_mode mode = storage_mode::ordered;
+};
+
+// Saved with the texture's asset id in place of the pointer. Restoring needs
+// a context with find_texture(nsc::asset_id), such as TextureCatalog.
+template <>
+struct archive_traits<ImageDesc>
+{
+	struct stored
+	{
+		asset_id texture;
+		rendering::Color color;
+		ui::Rectangle bounds;
+	};
+
+	static constexpr std::string_view key = "ImageDesc";
+
+	static stored to_stored(const ImageDesc &desc)
+	{
+		return stored { desc.texture ? desc.texture->id : null_asset, desc.color, desc.bounds };
+	}
+
+	template <typename Context>
+	static ImageDesc from_stored(const stored &saved, Context &catalog)
+	{
+		return ImageDesc { catalog.find_texture(saved.texture), saved.color, saved.bounds };
+	}
+};
+}
+
 struct TextDesc
 {
 	Font *font;
@@ -1,58 +1,53 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
-#include <unordered_map>
 
+#include "glyph_atlas.hpp"
+#include "glyph_table.hpp"
 #include "texture.hpp"
+#include "../core/asset.hpp"
 
+// One row of the metrics CSV that msdf-atlas-gen writes next to an atlas.
 struct Character {
-    char c;
-    double advance;
-
-    double plane_left;
-    double plane_bottom;
-    double plane_right;
-    double plane_top;
-
-    float texture_left;
-    float texture_bottom;
-    float texture_right;
-    float texture_top;
+    std::uint32_t codepoint;
+    GlyphMetrics metrics;
 
     void populate_from_line(std::string line) {
         std::istringstream ss(line);
         std::string field;
 
-        std::getline(ss, field, ',');
-        this->c = std::stoi(field);
+        auto next = [&]() {
+            std::getline(ss, field, ',');
+            return std::stof(field);
+        };
 
         std::getline(ss, field, ',');
-        this->advance = std::stod(field);
-        std::getline(ss, field, ',');
-        this->plane_left = std::stod(field);
-        std::getline(ss, field, ',');
-        this->plane_bottom = std::stod(field);
-        std::getline(ss, field, ',');
-        this->plane_right = std::stod(field);
-        std::getline(ss, field, ',');
-        this->plane_top = std::stod(field);
+        this->codepoint = static_cast<std::uint32_t>(std::stoul(field));
 
-        std::getline(ss, field, ',');
-        this->texture_left = std::stod(field);
-        std::getline(ss, field, ',');
-        this->texture_bottom = std::stod(field);
-        std::getline(ss, field, ',');
-        this->texture_right = std::stod(field);
-        std::getline(ss, field, ',');
-        this->texture_top = std::stod(field);
+        this->metrics.advance = next();
+        this->metrics.plane_left = next();
+        this->metrics.plane_bottom = next();
+        this->metrics.plane_right = next();
+        this->metrics.plane_top = next();
+
+        this->metrics.texture_left = next();
+        this->metrics.texture_bottom = next();
+        this->metrics.texture_right = next();
+        this->metrics.texture_top = next();
     }
 };
 
 struct Font {
-    std::unordered_map<char, Character> char_data;
+    GlyphTable glyphs;
     float max_height;
     nsc::rendering::Texture *texture;
+    // Same as atlas's texture, or null without an atlas.
     nsc::rendering::Texture *fallback_texture;
+    // Generates glyphs the prebuilt texture is missing, on demand.
+    std::unique_ptr<GlyphAtlas> atlas;
+    nsc::asset_id id;
 };
@@ -24,8 +24,10 @@ Font * FontCatalog::load_font(const std::string &path)
 {
 	if (!path_to_font.count(path)) {
 		auto out = calculate_out_name(path);
-		auto texture_name = out + ".msdfnt1";
-		auto csv_name = out + ".msdfnt2";
+		// .v2: baked at a fixed scale. Older caches may have larger glyphs
+		// than GlyphAtlas bakes, so they are not reused.
+		auto texture_name = out + ".v2.msdfnt1";
+		auto csv_name = out + ".v2.msdfnt2";
 
 		// Check if both files exist
 		if (!file_exists(texture_name) || !file_exists(csv_name)) {
@@ -35,6 +37,9 @@ Font * FontCatalog::load_font(const std::string &path)
 		auto font = Font {};
 		font.texture = texture_loader.load_texture(texture_name);
 		font.max_height = 0.0f;
+		font.id = nsc::make_asset_id(path);
+		font.atlas = std::make_unique<GlyphAtlas>(path);
+		font.fallback_texture = font.atlas->get_texture();
 
 		// Load the metadata
 		std::ifstream metadata_file(csv_name);
@@ -43,12 +48,13 @@ Font * FontCatalog::load_font(const std::string &path)
 		while(std::getline(metadata_file, line)) {
 			Character c;
 			c.populate_from_line(line);
-			font.char_data[c.c] = c;
+			font.glyphs.set(c.codepoint, c.metrics);
 
-			float height = c.plane_top - c.plane_bottom;
+			float height = c.metrics.plane_top - c.metrics.plane_bottom;
 			font.max_height = std::max(font.max_height, height);
 		}
-		path_to_font[path] = font;
+		id_to_path[font.id] = path;
+		path_to_font[path] = std::move(font);
 	}
 	return &path_to_font[path];
 }
@@ -76,6 +82,31 @@ void FontCatalog::release_font(const std::string &name)
 	// NOTE: This will likely require you to store the texture_loader
 }
 
+Font * FontCatalog::find_font(nsc::asset_id id)
+{
+	auto path = id_to_path.find(id);
+	if (path == id_to_path.end()) {
+		return nullptr;
+	}
+	return &path_to_font[path->second];
+}
+
+void FontCatalog::export_assets(nsc::asset_table &assets) const
+{
+	for (const auto &[id, path] : id_to_path) {
+		assets.add(id, nsc::asset_kind::font, path);
+	}
+}
+
+void FontCatalog::import_assets(const nsc::asset_table &assets)
+{
+	for (const auto &[id, entry] : assets.entries()) {
+		if (entry.kind == nsc::asset_kind::font) {
+			load_font(entry.path);
+		}
+	}
+}
+
 TextDesc FontCatalog::create(const std::string &msg,
 							 const std::string &font_path, size_t font_size,
 							 const nsc::rendering::Color &color,
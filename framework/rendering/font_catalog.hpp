@@ -17,12 +17,20 @@ public:
 	Font * load_font(const std::string &path);
 	void release_font(const std::string &name);
 
+	// Looks up a font that was loaded earlier by its asset id.
+	Font * find_font(nsc::asset_id id);
+	// Lists every loaded font, e.g. before saving a scene.
+	void export_assets(nsc::asset_table &assets) const;
+	// Loads every font listed, e.g. before restoring a scene.
+	void import_assets(const nsc::asset_table &assets);
+
 	TextDesc create(const std::string &msg, const std::string &font_path, size_t font_size, const nsc::rendering::Color &color, const nsc::ui::Rectangle &bounds);
 
 private:
 	std::string calculate_out_name(const std::string &path);
 	
 	std::unordered_map<std::string, Font> path_to_font;
+	std::unordered_map<nsc::asset_id, std::string> id_to_path;
 	MsdfWrapper wrapper;
 	TextureCatalog texture_loader;
 };
@@ -0,0 +1,233 @@
+#include "glyph_atlas.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <glad/glad.h>
+
+#include "msdf-atlas-gen.h"
+#include "msdf_wrapper.hpp"
+
+using namespace msdf_atlas;
+
+namespace {
+const double angle_threshold = 3.0;
+const double miter_limit = 1.0;
+const unsigned long long mcg_multiplier = 6364136223846793005ull;
+}
+
+GlyphAtlas::GlyphAtlas(const std::string &font_path)
+	: font_path(font_path), texture { 0, atlas_size, atlas_size, 3, nsc::null_asset },
+	  outstanding(0), revision(0), stop(false)
+{
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+	if (!worker.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	wake.notify_all();
+	worker.join();
+	glDeleteTextures(1, &texture.texture);
+}
+
+void GlyphAtlas::start()
+{
+	unsigned int id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D, id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, atlas_size, atlas_size, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	texture.texture = id;
+
+	worker = std::thread([this] { work(); });
+}
+
+const GlyphMetrics *GlyphAtlas::find(uint32_t codepoint)
+{
+	if (glyphs.contains(codepoint)) {
+		return &glyphs[codepoint];
+	}
+
+	if (requested.insert(codepoint).second) {
+		if (!worker.joinable()) {
+			start();
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(codepoint);
+		}
+		++outstanding;
+		wake.notify_one();
+	}
+	return nullptr;
+}
+
+void GlyphAtlas::upload()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+		if (!lock.owns_lock() || finished.empty()) {
+			return;
+		}
+		std::swap(finished, landed);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture.texture);
+	// Rows of RGB bytes are rarely a multiple of four long.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (const auto &glyph : landed) {
+		if (glyph.found) {
+			if (!glyph.pixels.empty()) {
+				glTexSubImage2D(GL_TEXTURE_2D, 0, glyph.x, glyph.y, glyph.width, glyph.height,
+								GL_RGB, GL_UNSIGNED_BYTE, glyph.pixels.data());
+			}
+			glyphs.set(glyph.codepoint, glyph.metrics);
+		}
+		--outstanding;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	landed.clear();
+	++revision;
+}
+
+// Fills rows left to right and starts a new row above the tallest box of
+// the last one when it runs out of width. Glyphs are never freed, so this
+// wastes little.
+bool GlyphAtlas::Shelves::place(int width, int height, int &out_x, int &out_y)
+{
+	if (width > atlas_size) {
+		return false;
+	}
+	if (x + width > atlas_size) {
+		x = 0;
+		y += row_height;
+		row_height = 0;
+	}
+	if (y + height > atlas_size) {
+		return false;
+	}
+
+	out_x = x;
+	out_y = y;
+	x += width;
+	row_height = std::max(row_height, height);
+	return true;
+}
+
+void GlyphAtlas::work()
+{
+	// The worker opens its own FreeType instance; the handles are not safe
+	// to share between threads.
+	auto ft = msdfgen::initializeFreetype();
+	auto font = ft ? msdfgen::loadFont(ft, font_path.c_str()) : nullptr;
+	if (!font) {
+		printf("Failed to load %s, glyphs outside the prebuilt atlas will not show.\n", font_path.c_str());
+	}
+
+	msdfgen::FontMetrics font_metrics = { };
+	if (font) {
+		msdfgen::getFontMetrics(font_metrics, font);
+	}
+	if (font_metrics.emSize <= 0) {
+		font_metrics.emSize = MsdfWrapper::em_size;
+	}
+	auto scale = MsdfWrapper::em_size / font_metrics.emSize;
+
+	GeneratorAttributes attributes;
+	attributes.overlapSupport = true;
+	attributes.scanlinePass = true;
+	attributes.errorCorrectionThreshold = MSDFGEN_DEFAULT_ERROR_CORRECTION_THRESHOLD;
+	unsigned long long seed = 0;
+
+	while (true) {
+		uint32_t codepoint;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stop || !queue.empty(); });
+			if (stop) {
+				break;
+			}
+			codepoint = queue.front();
+			queue.pop_front();
+		}
+
+		GeneratedGlyph out = { };
+		out.codepoint = codepoint;
+
+		GlyphGeometry glyph;
+		if (font && glyph.load(font, codepoint)) {
+			seed *= mcg_multiplier;
+			glyph.edgeColoring(angle_threshold, seed);
+			glyph.wrapBox(scale, MsdfWrapper::pixel_range / scale, miter_limit);
+
+			int box_width, box_height;
+			glyph.getBoxSize(box_width, box_height);
+
+			// Boxes are placed from the bottom of the atlas, as in the
+			// prebuilt one, so texture bounds mean the same in both.
+			int box_x = 0, box_y = 0;
+			if (box_width == 0 || box_height == 0 || shelves.place(box_width, box_height, box_x, box_y)) {
+				glyph.placeBox(box_x, box_y);
+				out.found = true;
+
+				double l, b, r, t;
+				out.metrics.advance = (float)(glyph.getAdvance() / font_metrics.emSize);
+				glyph.getQuadPlaneBounds(l, b, r, t);
+				out.metrics.plane_left = (float)(l / font_metrics.emSize);
+				out.metrics.plane_bottom = (float)(b / font_metrics.emSize);
+				out.metrics.plane_right = (float)(r / font_metrics.emSize);
+				out.metrics.plane_top = (float)(t / font_metrics.emSize);
+				glyph.getQuadAtlasBounds(l, b, r, t);
+				out.metrics.texture_left = (float)l;
+				out.metrics.texture_bottom = (float)b;
+				out.metrics.texture_right = (float)r;
+				out.metrics.texture_top = (float)t;
+
+				if (box_width > 0 && box_height > 0) {
+					msdfgen::Bitmap<float, 3> bitmap(box_width, box_height);
+					msdfGenerator(bitmap, glyph, attributes);
+
+					// The bitmap's rows run bottom to top; texture rows
+					// run top to bottom.
+					out.x = box_x;
+					out.y = atlas_size - box_y - box_height;
+					out.width = box_width;
+					out.height = box_height;
+					out.pixels.resize((size_t)box_width * box_height * 3);
+					auto pixel = out.pixels.data();
+					for (int row = box_height - 1; row >= 0; --row) {
+						for (int column = 0; column < box_width; ++column) {
+							auto source = bitmap(column, row);
+							*pixel++ = msdfgen::pixelFloatToByte(source[0]);
+							*pixel++ = msdfgen::pixelFloatToByte(source[1]);
+							*pixel++ = msdfgen::pixelFloatToByte(source[2]);
+						}
+					}
+				}
+			} else {
+				printf("Glyph atlas for %s is full, codepoint 0x%X will not show.\n", font_path.c_str(), codepoint);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		finished.push_back(std::move(out));
+	}
+
+	if (font) {
+		msdfgen::destroyFont(font);
+	}
+	if (ft) {
+		msdfgen::deinitializeFreetype(ft);
+	}
+}
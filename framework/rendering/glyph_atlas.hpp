@@ -0,0 +1,99 @@
+#ifndef GLYPH_ATLAS_HPP_
+#define GLYPH_ATLAS_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "glyph_table.hpp"
+#include "texture.hpp"
+
+// A texture that fills up with glyphs as text asks for them, for codepoints
+// the font's prebuilt atlas does not cover. Glyphs are generated on a
+// worker thread and copied into free space in the texture by upload(), so
+// asking for one never stalls a frame: find() answers null until it lands.
+//
+// Glyphs use the same em size and pixel range as the prebuilt atlas, so the
+// text shader draws both the same way. Everything but the worker runs on
+// the thread that owns the GL context.
+//
+// Most fonts never need a glyph outside their prebuilt atlas, so the
+// texture, the worker and its FreeType instance are only created by the
+// first find() that misses.
+class GlyphAtlas
+{
+public:
+	static constexpr int atlas_size = 1024;
+
+	explicit GlyphAtlas(const std::string &font_path);
+	~GlyphAtlas();
+
+	GlyphAtlas(const GlyphAtlas &) = delete;
+	GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+	// Returns the glyph if it is in the texture. Otherwise queues it, unless
+	// it was asked for before, and returns null.
+	const GlyphMetrics *find(uint32_t codepoint);
+
+	// Copies finished glyphs into the texture. Skips the frame rather than
+	// wait if the worker is holding the lock.
+	void upload();
+
+	// True while asked-for glyphs have not been uploaded yet.
+	bool is_waiting() const { return outstanding > 0; }
+	// Changes whenever upload() adds glyphs, so layouts that used a
+	// placeholder know to lay themselves out again.
+	uint32_t get_revision() const { return revision; }
+	nsc::rendering::Texture *get_texture() { return &texture; }
+
+private:
+	struct GeneratedGlyph
+	{
+		uint32_t codepoint;
+		// False if the font has no such glyph or the texture is full.
+		bool found;
+		GlyphMetrics metrics;
+		// Where the pixels go, in texture rows from the top.
+		int x, y, width, height;
+		std::vector<unsigned char> pixels;
+	};
+
+	// Shelf packing state; only the worker touches it.
+	struct Shelves
+	{
+		int x = 0;
+		int y = 0;
+		int row_height = 0;
+
+		bool place(int width, int height, int &out_x, int &out_y);
+	};
+
+	// Creates the texture and starts the worker.
+	void start();
+	void work();
+
+	std::string font_path;
+	nsc::rendering::Texture texture;
+	GlyphTable glyphs;
+	std::unordered_set<uint32_t> requested;
+	size_t outstanding;
+	uint32_t revision;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<uint32_t> queue;
+	std::vector<GeneratedGlyph> finished;
+	std::vector<GeneratedGlyph> landed;
+	bool stop;
+	Shelves shelves;
+
+	// Not joinable until start().
+	std::thread worker;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "glyph_batcher.hpp"
+
+#include <algorithm>
+
+namespace {
+uint32_t pack_color(const nsc::rendering::Color &color)
+{
+	auto channel = [](float v) {
+		return (uint32_t)(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+	};
+	return channel(color.r) | (channel(color.g) << 8) | (channel(color.b) << 16) | (channel(color.a) << 24);
+}
+}
+
+void GlyphBatcher::clear()
+{
+	layouts.next_frame();
+	for (auto &s : staging) {
+		s.instances.clear();
+	}
+	instances.clear();
+	batches.clear();
+}
+
+std::vector<GlyphInstance> &GlyphBatcher::staging_for(nsc::rendering::Texture *texture)
+{
+	// A frame uses a handful of atlases at most, so a linear scan wins.
+	for (auto &s : staging) {
+		if (s.texture == texture) {
+			return s.instances;
+		}
+	}
+	staging.push_back(Staging { texture, {} });
+	return staging.back().instances;
+}
+
+void GlyphBatcher::add_layout(const TextLayout &layout, const nsc::rendering::Color &color, float x, float y)
+{
+	auto packed = pack_color(color);
+	add_run(layout.texture, layout.glyphs, packed, x, y);
+	if (!layout.atlas_glyphs.empty()) {
+		add_run(layout.atlas_texture, layout.atlas_glyphs, packed, x, y);
+	}
+}
+
+void GlyphBatcher::add_run(nsc::rendering::Texture *texture, const std::vector<GlyphInstance> &glyphs,
+						   uint32_t color, float x, float y)
+{
+	auto &out = staging_for(texture);
+	for (auto instance : glyphs) {
+		instance.x += x;
+		instance.y += y;
+		instance.color = color;
+		out.push_back(instance);
+	}
+}
+
+void GlyphBatcher::add_text(const TextDesc &desc)
+{
+	const auto &bounds = desc.bounds;
+	const auto &layout = layouts.get(desc.font, desc.font_size, desc.msg);
+
+	auto center_x = bounds.x + bounds.width / 2.f;
+	auto center_y = bounds.y + bounds.height / 2.f;
+	add_layout(layout, desc.color, center_x - layout.width / 2.f, center_y - layout.height / 2.f);
+}
+
+void GlyphBatcher::add_rich_text(const RichTextDesc &desc)
+{
+	const auto &bounds = desc.bounds;
+	auto x = bounds.x;
+	auto y = bounds.y;
+
+	chunk_layouts.clear();
+	auto text_height = 0.f;
+	auto text_width = 0.f;
+	for (const auto &chunk : desc.text_chunks) {
+		const auto &layout = layouts.get(chunk.font, chunk.font_size, chunk.msg);
+		chunk_layouts.push_back(&layout);
+		text_height = std::max(text_height, layout.height);
+		text_width += layout.width;
+	}
+
+	if (desc.is_centered_x) {
+		x = bounds.x + bounds.width / 2.f - text_width / 2.f;
+	}
+	if (desc.is_centered_y) {
+		y = bounds.y + bounds.height / 2.f - text_height / 2.f;
+	}
+
+	for (size_t i = 0; i < desc.text_chunks.size(); ++i) {
+		add_layout(*chunk_layouts[i], desc.text_chunks[i].color, x, y);
+		x += chunk_layouts[i]->width;
+	}
+}
+
+void GlyphBatcher::finish()
+{
+	instances.clear();
+	batches.clear();
+	for (auto &s : staging) {
+		if (s.instances.empty()) {
+			continue;
+		}
+		batches.push_back(GlyphBatch { s.texture, (uint32_t)instances.size(), (uint32_t)s.instances.size() });
+		instances.insert(instances.end(), s.instances.begin(), s.instances.end());
+	}
+}
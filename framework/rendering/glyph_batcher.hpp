@@ -0,0 +1,65 @@
+#ifndef GLYPH_BATCHER_HPP_
+#define GLYPH_BATCHER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "descriptions.hpp"
+#include "font.hpp"
+#include "glyph_instance.hpp"
+#include "text_layout_cache.hpp"
+
+// A run of instances that all sample the same atlas and can be drawn with a
+// single instanced call.
+struct GlyphBatch
+{
+	nsc::rendering::Texture *texture;
+	uint32_t first;
+	uint32_t count;
+};
+
+// Lays text out into per-atlas runs of glyph instances. It touches no GL
+// state, so the CPU side of text rendering can be timed without a window.
+// Buffers are kept between frames; clear() only resets their sizes. Each
+// string is laid out once and then reused from a TextLayoutCache for as long
+// as it keeps being drawn, so static labels are only copied and offset.
+class GlyphBatcher
+{
+public:
+	// Starts a new frame.
+	void clear();
+
+	// Centered in desc.bounds on a single line.
+	void add_text(const TextDesc &desc);
+	void add_rich_text(const RichTextDesc &desc);
+
+	// Gathers every atlas's glyphs into one contiguous array. Call after the
+	// last add and before reading instances or batches.
+	void finish();
+
+	const std::vector<GlyphInstance> &get_instances() const { return instances; }
+	const std::vector<GlyphBatch> &get_batches() const { return batches; }
+	// Font atlases still generating glyphs that this text is waiting on.
+	const std::vector<GlyphAtlas *> &get_waiting_atlases() const { return layouts.get_waiting_atlases(); }
+
+private:
+	struct Staging
+	{
+		nsc::rendering::Texture *texture;
+		std::vector<GlyphInstance> instances;
+	};
+
+	std::vector<GlyphInstance> &staging_for(nsc::rendering::Texture *texture);
+	void add_layout(const TextLayout &layout, const nsc::rendering::Color &color, float x, float y);
+	void add_run(nsc::rendering::Texture *texture, const std::vector<GlyphInstance> &glyphs,
+				 uint32_t color, float x, float y);
+
+	TextLayoutCache layouts;
+	std::vector<const TextLayout *> chunk_layouts;
+	std::vector<Staging> staging;
+	std::vector<GlyphInstance> instances;
+	std::vector<GlyphBatch> batches;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef GLYPH_INSTANCE_HPP_
+#define GLYPH_INSTANCE_HPP_
+
+#include <cstdint>
+
+// One glyph quad as the instanced text shader reads it: where it goes on
+// screen, which part of the atlas it samples, and how it is shaded.
+struct GlyphInstance
+{
+	float x, y, width, height;
+	// Normalized texture coordinates of the glyph's bottom-left and
+	// top-right corners.
+	float u0, v0, u1, v1;
+	float distance_factor;
+	// RGBA, 8 bits per channel.
+	uint32_t color;
+};
+
+#endif
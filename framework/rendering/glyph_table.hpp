@@ -0,0 +1,93 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Everything text layout needs to know about one glyph, packed into nine
+// floats. Plane bounds are in ems relative to the pen; texture bounds are in
+// atlas pixels from the bottom-left.
+struct GlyphMetrics {
+    float advance;
+
+    float plane_left;
+    float plane_bottom;
+    float plane_right;
+    float plane_top;
+
+    float texture_left;
+    float texture_bottom;
+    float texture_right;
+    float texture_top;
+};
+
+// Glyph metrics indexed by codepoint. Codepoints below base_range live in a
+// flat array, so laying out Latin text is an array index per character;
+// anything above falls back to a hash map. Codepoints with no glyph get
+// all-zero metrics: no quad and no advance.
+//
+// The base range's advances and heights are also kept as plain float
+// arrays, so measure_text can load them eight at a time.
+class GlyphTable {
+public:
+    static constexpr std::uint32_t base_range = 256;
+
+    GlyphTable() : base(base_range), advance_table(base_range), height_table(base_range) {}
+
+    const GlyphMetrics& operator[](std::uint32_t codepoint) const {
+        if (codepoint < base_range) {
+            return base[codepoint];
+        }
+        return find_extra(codepoint);
+    }
+
+    // Only for bytes of a char string; skips the range check.
+    const GlyphMetrics& operator[](char c) const { return base[static_cast<unsigned char>(c)]; }
+
+    bool contains(std::uint32_t codepoint) const {
+        if (codepoint < base_range) {
+            return present[codepoint];
+        }
+        return extra.count(codepoint) != 0;
+    }
+
+    // True once every printable ASCII character has a glyph, so any run of
+    // ASCII bytes can be measured from the flat tables alone.
+    bool covers_ascii() const { return ascii_present == ascii_printable; }
+
+    // Indexed by codepoint, base_range long. A space counts as zero height,
+    // as text is measured without it.
+    const float* advances() const { return advance_table.data(); }
+    const float* heights() const { return height_table.data(); }
+
+    void set(std::uint32_t codepoint, const GlyphMetrics& metrics) {
+        if (codepoint < base_range) {
+            if (codepoint >= ' ' && codepoint < 0x7F && !present[codepoint]) {
+                ++ascii_present;
+            }
+            base[codepoint] = metrics;
+            present[codepoint] = true;
+            advance_table[codepoint] = metrics.advance;
+            height_table[codepoint] = codepoint == ' ' ? 0.0f : metrics.plane_top - metrics.plane_bottom;
+        } else {
+            extra[codepoint] = metrics;
+        }
+    }
+
+private:
+    static constexpr std::uint32_t ascii_printable = 0x7F - ' ';
+
+    const GlyphMetrics& find_extra(std::uint32_t codepoint) const {
+        static const GlyphMetrics missing{};
+        auto it = extra.find(codepoint);
+        return it == extra.end() ? missing : it->second;
+    }
+
+    std::vector<GlyphMetrics> base;
+    std::bitset<base_range> present;
+    std::uint32_t ascii_present = 0;
+    std::vector<float> advance_table;
+    std::vector<float> height_table;
+    std::unordered_map<std::uint32_t, GlyphMetrics> extra;
+};
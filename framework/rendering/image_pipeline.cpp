@@ -34,13 +34,18 @@ ImagePipeline::ImagePipeline()
 ImagePipeline::~ImagePipeline() {
 }
 
-void ImagePipeline::render(nsc::registry *descs,
+void ImagePipeline::render(const nsc::registry *descs,
                            const glm::mat4 &proj, const glm::mat4 &view) {
     shader.use();
     shader.set_mat4("projection", proj);
     shader.set_mat4("view", view);
 
-    for (auto desc : *(descs->get_group<ImageDesc>())) {
+    auto images = descs->get_group<ImageDesc>();
+    if (!images) {
+        return;
+    }
+
+    for (const auto &desc : *images) {
         auto bounds = desc.bounds;
 
         auto model = glm::mat4(1.0f);
@@ -12,7 +12,7 @@ class ImagePipeline {
     ImagePipeline();
     ~ImagePipeline();
 
-    void render(nsc::registry *descs,
+    void render(const nsc::registry *descs,
                 const glm::mat4 &proj, const glm::mat4 &view);
 
    private:
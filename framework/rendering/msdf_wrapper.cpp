@@ -13,8 +13,8 @@ using namespace msdf_atlas;
 
 #define DEFAULT_ANGLE_THRESHOLD 3.0
 #define DEFAULT_MITER_LIMIT 1.0
-#define DEFAULT_EM_SIZE 64
-#define DEFAULT_PIXEL_RANGE 8.0
+#define DEFAULT_EM_SIZE MsdfWrapper::em_size
+#define DEFAULT_PIXEL_RANGE MsdfWrapper::pixel_range
 #define SDF_ERROR_ESTIMATE_PRECISION 19
 #define GLYPH_FILL_RULE msdfgen::FILL_NONZERO
 #define MCG_MULTIPLIER 6364136223846793005ull
@@ -119,6 +119,9 @@ int MsdfWrapper::load_font(const std::string& path, const std::string &out_img,
     TightAtlasPacker::DimensionsConstraint atlasSizeConstraint = TightAtlasPacker::DimensionsConstraint::MULTIPLE_OF_FOUR_SQUARE;
     config.angleThreshold = DEFAULT_ANGLE_THRESHOLD;
     config.miterLimit = DEFAULT_MITER_LIMIT;
+    // A fixed scale: with only a minimum, the packer grows glyphs to fill
+    // the atlas, and they would no longer match the ones GlyphAtlas bakes.
+    config.emSize = DEFAULT_EM_SIZE;
     config.threadCount = std::max((int)std::thread::hardware_concurrency(), 1);
     config.imageType = ImageType::MSDF;
     config.imageFormat = ImageFormat::BMP;
@@ -5,6 +5,12 @@
 
 struct MsdfWrapper
 {
+	// Every atlas, prebuilt or filled at run time by GlyphAtlas, is baked at
+	// this many pixels per em with this distance range in pixels, so one
+	// distance factor fits glyphs from any of them.
+	static constexpr double em_size = 64.0;
+	static constexpr double pixel_range = 8.0;
+
 	int load_font(const std::string &path, const std::string &out_img, const std::string &out_csv);
 };
 
@@ -18,7 +18,7 @@ Renderer::~Renderer()
 {
 }
 
-void Renderer::render(nsc::registry *scene, Window *window, Camera *camera)
+void Renderer::render(const nsc::registry *scene, Window *window, Camera *camera)
 {
 	// Get the list of objects for the pipelines
 	auto width = window->get_width();
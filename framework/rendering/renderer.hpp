@@ -16,7 +16,7 @@ public:
 	Renderer();
 	~Renderer();
 
-	void render(nsc::registry *scene, Window *window, Camera *camera);
+	void render(const nsc::registry *scene, Window *window, Camera *camera);
 private:
 	std::unique_ptr<TextPipeline> text_pipeline;
 	std::unique_ptr<ImagePipeline> image_pipeline;
@@ -1,91 +1,248 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
-#include <optional>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "../core/memory.hpp"
+#include "../core/registry.hpp"
+#include "../core/type_index.hpp"
+
 namespace nsc::rendering::detail {
 
+// A type-erased renderable for types that are not worth a bucket of their
+// own in renderer_registry. Models of up to inline_capacity bytes are kept
+// inside the renderable; larger ones are allocated from resource.
 template <typename... Args>
 struct renderable {
    public:
+    static constexpr std::size_t inline_capacity = 48;
+
     template <typename T>
-    renderable(T x) : self_(std::make_unique<model_t<T>>(std::move(x))) {}
+    renderable(T x, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+        if constexpr (sizeof(model_t<T>) <= inline_capacity && alignof(model_t<T>) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<T>) {
+            self_ = ::new (static_cast<void*>(&buffer_)) model_t<T>(std::move(x));
+        } else {
+            heap_ = make_pmr_unique<model_t<T>>(resource, std::move(x));
+            self_ = heap_.get();
+        }
+    }
+
+    renderable(renderable&& other) noexcept { _take(other); }
+
+    renderable& operator=(renderable&& other) noexcept {
+        if (this != &other) {
+            _reset();
+            _take(other);
+        }
+        return *this;
+    }
+
+    ~renderable() { _reset(); }
 
     void render(Args... args) {
-        self_->render(std::forward<Args>(args)...);
+        self_->render(args...);
     }
 
    private:
     struct concept_t {
         virtual ~concept_t() = default;
         virtual void render(Args... args) = 0;
+        // Move-constructs this model into buffer and returns it there.
+        virtual concept_t* move_to(void* buffer) noexcept = 0;
     };
 
     template <typename T>
     struct model_t final : concept_t {
         model_t(T x) : data_(std::move(x)) {}
-        virtual void render(Args... args) override { data_.render(std::forward<Args>(args)...); }
+        virtual void render(Args... args) override { data_.render(args...); }
+        virtual concept_t* move_to(void* buffer) noexcept override {
+            return ::new (buffer) model_t(std::move(data_));
+        }
         T data_;
     };
 
-    std::unique_ptr<concept_t> self_;
+    bool _is_inline() const noexcept { return self_ && !heap_; }
+
+    void _take(renderable& other) noexcept {
+        if (other.heap_) {
+            heap_ = std::move(other.heap_);
+            self_ = heap_.get();
+        } else if (other.self_) {
+            self_ = other.self_->move_to(&buffer_);
+            other.self_->~concept_t();
+        }
+        other.self_ = nullptr;
+    }
+
+    void _reset() noexcept {
+        if (_is_inline()) {
+            self_->~concept_t();
+        }
+        heap_.reset();
+        self_ = nullptr;
+    }
+
+    alignas(std::max_align_t) std::byte buffer_[inline_capacity];
+    concept_t* self_ = nullptr;
+    pmr_ptr<concept_t> heap_;
+};
+
+template <typename... Args>
+struct _renderable_bucket {
+    virtual ~_renderable_bucket() = default;
+    virtual void render(Args... args) = 0;
+    // Swap-removes the renderable at slot and returns the handle of the one
+    // that moved into it, or null_handle if none did.
+    virtual obj_handle remove(std::uint32_t slot) = 0;
+    virtual void clear() = 0;
+    virtual std::span<const obj_handle> handles() const noexcept = 0;
+};
+
+// All renderables of one type, stored by value. T::render is called
+// directly in a loop, so it can be inlined.
+template <typename T, typename... Args>
+struct renderable_bucket final : _renderable_bucket<Args...> {
+    explicit renderable_bucket(std::pmr::memory_resource* resource) : values(resource), owners(resource) {}
+
+    void render(Args... args) override {
+        for (auto& value : values) {
+            value.render(args...);
+        }
+    }
+
+    obj_handle remove(std::uint32_t slot) override {
+        auto last = values.size() - 1;
+        obj_handle moved = null_handle;
+        if (slot != last) {
+            values[slot] = std::move(values[last]);
+            owners[slot] = owners[last];
+            moved = owners[slot];
+        }
+        values.pop_back();
+        owners.pop_back();
+        return moved;
+    }
+
+    void clear() override {
+        values.clear();
+        owners.clear();
+    }
+
+    std::span<const obj_handle> handles() const noexcept override { return owners; }
+
+    std::pmr::vector<T> values;
+    std::pmr::vector<obj_handle> owners;
 };
 }  // namespace btn::rendering::detail
 
 namespace nsc::rendering {
 
-using renderable_handle = int;
-
+using renderable_handle = nsc::obj_handle;
+
+// Keeps renderables grouped by concrete type, each type in its own
+// contiguous vector. render() makes one virtual call per type and then
+// calls T::render on every value in a plain loop, instead of a virtual call
+// and a pointer chase per renderable.
+//
+// Renderables are drawn type by type, in the order the types were first
+// used by any registry; within a type, removal may reorder them. Types that
+// are rare enough not to deserve a bucket can be type-erased into a
+// detail::renderable first, which go into a bucket of their own.
 template <typename... Args>
 struct renderer_registry {
-    renderer_registry() {}
+    explicit renderer_registry(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : pool_(resource), locations_(resource), buckets_(resource) {}
     ~renderer_registry() {}
 
-    renderable_handle emplace_renderable(detail::renderable<Args...> renderable) {
-        auto handle = _get_next_renderable_handle();
-        renderables_.emplace_back(handle, std::move(renderable));
-        ++size_;
+    template <typename T>
+    renderable_handle emplace(T x) {
+        auto bucket = _get_bucket<T>();
+        auto handle = pool_.create();
+        auto index = nsc::detail::handle_index(handle);
+        if (index >= locations_.size()) {
+            locations_.resize(index + 1);
+        }
+        locations_[index] = location{static_cast<std::uint32_t>(nsc::detail::type_index<renderer_registry>::template of<T>()),
+                                     static_cast<std::uint32_t>(bucket->values.size())};
+        bucket->values.push_back(std::move(x));
+        bucket->owners.push_back(handle);
         return handle;
     }
 
-    void remove_renderable(const renderable_handle& handle) {
-        auto pos = std::lower_bound(
-            renderables_.begin(), renderables_.end(), handle,
-            [](const auto& a, const auto& b) { return a.first < b; });
+    renderable_handle emplace_renderable(detail::renderable<Args...> renderable) {
+        return emplace<detail::renderable<Args...>>(std::move(renderable));
+    }
 
-        if (pos == renderables_.end() || pos->first != handle) {
+    // Type-erases x into the shared fallback bucket instead of giving T a
+    // bucket of its own.
+    template <typename T>
+    renderable_handle emplace_erased(T x) {
+        auto resource = buckets_.get_allocator().resource();
+        return emplace_renderable(detail::renderable<Args...>(std::move(x), resource));
+    }
+
+    void remove_renderable(const renderable_handle& handle) {
+        if (!pool_.is_alive(handle)) {
             return;
         }
 
-        pos->second.reset();
-        --size_;
-
-        if (size_ < (renderables_.size() / 2)) {
-            renderables_.erase(std::remove_if(renderables_.begin(), renderables_.end(), [](const auto& e) { return !e.second; }));
+        auto at = locations_[nsc::detail::handle_index(handle)];
+        auto moved = buckets_[at.bucket]->remove(at.slot);
+        if (moved != null_handle) {
+            locations_[nsc::detail::handle_index(moved)].slot = at.slot;
         }
+        pool_.release(handle);
     }
 
     void clear_renderables() {
-        renderables_.clear();
+        for (auto& bucket : buckets_) {
+            if (bucket) {
+                for (auto handle : bucket->handles()) {
+                    pool_.release(handle);
+                }
+                bucket->clear();
+            }
+        }
     }
 
     void render(Args... args) {
-        for (auto& renderable : renderables_) {
-            if (renderable.second) {
-                (*renderable.second).render(std::forward<Args>(args)...);
+        for (auto& bucket : buckets_) {
+            if (bucket) {
+                bucket->render(args...);
             }
         }
     }
 
    private:
-    std::vector<std::pair<renderable_handle, std::optional<detail::renderable<Args...>>>> renderables_;
-    size_t size_;
+    struct location {
+        std::uint32_t bucket;
+        std::uint32_t slot;
+    };
+
+    nsc::detail::handle_pool pool_;
+    std::pmr::vector<location> locations_;
+    // Indexed by type_index<renderer_registry>; null for unused types.
+    std::pmr::vector<pmr_ptr<detail::_renderable_bucket<Args...>>> buckets_;
 
-    inline renderable_handle _get_next_renderable_handle() noexcept {
-        static renderable_handle id_ = 0;
-        return id_++;
+    template <typename T>
+    detail::renderable_bucket<T, Args...>* _get_bucket() {
+        auto id = nsc::detail::type_index<renderer_registry>::template of<T>();
+        if (id >= buckets_.size()) {
+            buckets_.resize(id + 1);
+        }
+        if (!buckets_[id]) {
+            auto resource = buckets_.get_allocator().resource();
+            buckets_[id] = make_pmr_unique<detail::renderable_bucket<T, Args...>>(resource, resource);
+        }
+        return static_cast<detail::renderable_bucket<T, Args...>*>(buckets_[id].get());
     }
 };
-}  // namespace btn::rendering
\ No newline at end of file
+}  // namespace btn::rendering
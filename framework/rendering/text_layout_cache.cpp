@@ -0,0 +1,102 @@
+#include "text_layout_cache.hpp"
+
+#include <algorithm>
+#include <functional>
+
+#include "msdf_wrapper.hpp"
+#include "text_measure.hpp"
+#include "../core/utf8.hpp"
+
+size_t TextLayoutCache::KeyHash::operator()(const KeyView &key) const
+{
+	auto hash = std::hash<std::string_view> {}(key.msg);
+	hash ^= std::hash<Font *> {}(key.font) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	hash ^= key.font_size + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	return hash;
+}
+
+const TextLayout &TextLayoutCache::get(Font *font, size_t font_size, std::string_view msg)
+{
+	auto it = layouts.find(KeyView { font, font_size, msg });
+	if (it == layouts.end()) {
+		it = layouts.emplace(Key { font, font_size, std::string(msg) }, TextLayout {}).first;
+		measure(font, font_size, msg, it->second);
+	} else if (it->second.has_placeholders && it->second.atlas_revision != font->atlas->get_revision()) {
+		measure(font, font_size, msg, it->second);
+	}
+	it->second.last_used = frame;
+	return it->second;
+}
+
+// Extents come from measure_text, so centered text is placed with the same
+// numbers anything else measuring the string gets; the loop below only
+// positions the quads.
+void TextLayoutCache::measure(Font *font, size_t font_size, std::string_view msg, TextLayout &layout)
+{
+	auto size = (float)font_size;
+	auto distance_factor = (float)(MsdfWrapper::pixel_range * size / MsdfWrapper::em_size);
+	auto atlas = font->atlas.get();
+
+	auto extents = measure_text(*font, font_size, msg);
+	layout.width = extents.width;
+	layout.height = extents.height;
+	layout.texture = font->texture;
+	layout.glyphs.clear();
+	layout.glyphs.reserve(msg.size());
+	layout.atlas_texture = atlas ? atlas->get_texture() : nullptr;
+	layout.atlas_glyphs.clear();
+	layout.has_placeholders = extents.has_placeholders;
+	layout.atlas_revision = atlas ? atlas->get_revision() : 0;
+	if (layout.has_placeholders && std::find(waiting.begin(), waiting.end(), atlas) == waiting.end()) {
+		waiting.push_back(atlas);
+	}
+
+	auto x = 0.f;
+	size_t i = 0;
+	while (i < msg.size()) {
+		auto codepoint = nsc::utf8_next(msg, i);
+		auto choice = choose_glyph(*font, codepoint);
+		auto glyph = choice.glyph;
+
+		if (codepoint != ' ' && glyph->plane_right > glyph->plane_left) {
+			// Atlas bounds are in pixels from the bottom of the atlas;
+			// texture rows start at the top.
+			auto texture_width = (float)choice.texture->width;
+			auto texture_height = (float)choice.texture->height;
+
+			GlyphInstance instance;
+			instance.x = x + glyph->plane_left * size;
+			instance.y = glyph->plane_bottom * size;
+			instance.width = (glyph->plane_right - glyph->plane_left) * size;
+			instance.height = (glyph->plane_top - glyph->plane_bottom) * size;
+			instance.u0 = glyph->texture_left / texture_width;
+			instance.v0 = 1.0f - glyph->texture_bottom / texture_height;
+			instance.u1 = glyph->texture_right / texture_width;
+			instance.v1 = 1.0f - glyph->texture_top / texture_height;
+			instance.distance_factor = distance_factor;
+			instance.color = 0;
+			(choice.from_atlas ? layout.atlas_glyphs : layout.glyphs).push_back(instance);
+		}
+		x += glyph->advance * size;
+	}
+}
+
+void TextLayoutCache::next_frame()
+{
+	std::erase_if(waiting, [](GlyphAtlas *atlas) { return !atlas->is_waiting(); });
+
+	++frame;
+	// Sweeping only every max_age frames keeps static text free of any
+	// per-frame cost beyond the lookup.
+	if (frame % max_age != 0) {
+		return;
+	}
+	std::erase_if(layouts, [this](const auto &entry) {
+		return entry.second.last_used + max_age < frame;
+	});
+}
+
+void TextLayoutCache::clear()
+{
+	layouts.clear();
+}
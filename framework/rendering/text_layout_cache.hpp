@@ -0,0 +1,97 @@
+#ifndef TEXT_LAYOUT_CACHE_HPP_
+#define TEXT_LAYOUT_CACHE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "font.hpp"
+#include "glyph_instance.hpp"
+
+// A single line of text laid out from a pen position of (0, 0).
+struct TextLayout
+{
+	// Sum of the advances, i.e. where the pen ends up.
+	float width;
+	// Tallest glyph, ignoring spaces.
+	float height;
+	nsc::rendering::Texture *texture;
+	// Positioned relative to the pen, with color left unset.
+	std::vector<GlyphInstance> glyphs;
+	// Glyphs from the font's GlyphAtlas, which has a texture of its own.
+	nsc::rendering::Texture *atlas_texture;
+	std::vector<GlyphInstance> atlas_glyphs;
+	// Some glyphs were still being generated and stand in as placeholders;
+	// the layout is redone once the atlas revision moves past this one.
+	bool has_placeholders;
+	uint32_t atlas_revision;
+	uint64_t last_used;
+};
+
+// Remembers the layout of every (font, size, string) it is asked for, so
+// text that does not change between frames is measured once. Layouts not
+// asked for during the last max_age frames are dropped.
+//
+// Strings are UTF-8. Codepoints the font's prebuilt atlas lacks come from
+// its GlyphAtlas, drawn as '?' until they are ready.
+class TextLayoutCache
+{
+public:
+	static constexpr uint64_t max_age = 120;
+
+	// The reference stays valid until the next call to next_frame or clear.
+	const TextLayout &get(Font *font, size_t font_size, std::string_view msg);
+
+	void next_frame();
+	void clear();
+	size_t size() const { return layouts.size(); }
+
+	// Atlases that layouts are waiting on; someone with the GL context has
+	// to call upload() on them.
+	const std::vector<GlyphAtlas *> &get_waiting_atlases() const { return waiting; }
+
+private:
+	struct Key
+	{
+		Font *font;
+		size_t font_size;
+		std::string msg;
+	};
+
+	// Lets get() look a string_view up without building a Key.
+	struct KeyView
+	{
+		Font *font;
+		size_t font_size;
+		std::string_view msg;
+	};
+
+	struct KeyHash
+	{
+		using is_transparent = void;
+		size_t operator()(const KeyView &key) const;
+		size_t operator()(const Key &key) const { return (*this)(KeyView { key.font, key.font_size, key.msg }); }
+	};
+
+	struct KeyEqual
+	{
+		using is_transparent = void;
+		bool operator()(const KeyView &a, const KeyView &b) const
+		{
+			return a.font == b.font && a.font_size == b.font_size && a.msg == b.msg;
+		}
+		bool operator()(const Key &a, const KeyView &b) const { return (*this)(KeyView { a.font, a.font_size, a.msg }, b); }
+		bool operator()(const KeyView &a, const Key &b) const { return (*this)(a, KeyView { b.font, b.font_size, b.msg }); }
+		bool operator()(const Key &a, const Key &b) const { return (*this)(KeyView { a.font, a.font_size, a.msg }, b); }
+	};
+
+	void measure(Font *font, size_t font_size, std::string_view msg, TextLayout &layout);
+
+	std::unordered_map<Key, TextLayout, KeyHash, KeyEqual> layouts;
+	std::vector<GlyphAtlas *> waiting;
+	uint64_t frame = 0;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "text_measure.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#include "../core/utf8.hpp"
+
+#if !defined(NSC_NO_SIMD) && defined(__AVX2__)
+#define NSC_MEASURE_AVX2
+#include <immintrin.h>
+#elif !defined(NSC_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define NSC_MEASURE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace {
+bool is_control(uint32_t codepoint)
+{
+	return codepoint < ' ' || codepoint == 0x7F;
+}
+
+// How many bytes at the start of text the flat tables can measure: ASCII
+// the font has glyphs for, and control characters, which measure as
+// nothing.
+size_t table_run(const GlyphTable &glyphs, const unsigned char *text, size_t count)
+{
+	size_t i = 0;
+	if (glyphs.covers_ascii()) {
+#if defined(NSC_MEASURE_AVX2) || defined(NSC_MEASURE_SSE)
+		// Only bytes of multibyte sequences have the top bit set.
+		for (; i + 16 <= count; i += 16) {
+			auto high = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(text + i)));
+			if (high != 0) {
+				return i + std::countr_zero((unsigned)high);
+			}
+		}
+#endif
+		while (i < count && text[i] < 0x80) {
+			++i;
+		}
+		return i;
+	}
+
+	while (i < count && text[i] < 0x80 && (is_control(text[i]) || glyphs.contains(text[i]))) {
+		++i;
+	}
+	return i;
+}
+
+void measure_scalar(const float *advances, const float *heights, const unsigned char *text, size_t count,
+					float &width, float &height)
+{
+	for (size_t i = 0; i < count; ++i) {
+		width += advances[text[i]];
+		height = std::max(height, heights[text[i]]);
+	}
+}
+
+#if defined(NSC_MEASURE_AVX2)
+float horizontal_add(__m256 v)
+{
+	auto sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+}
+
+float horizontal_max(__m256 v)
+{
+	auto max = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	max = _mm_max_ps(max, _mm_movehl_ps(max, max));
+	max = _mm_max_ss(max, _mm_shuffle_ps(max, max, 1));
+	return _mm_cvtss_f32(max);
+}
+
+// Widens eight bytes to indices and gathers their advances and heights.
+// Two sets of accumulators keep consecutive adds independent.
+size_t measure_simd(const float *advances, const float *heights, const unsigned char *text, size_t count,
+					float &width, float &height)
+{
+	auto width0 = _mm256_setzero_ps();
+	auto width1 = _mm256_setzero_ps();
+	auto height0 = _mm256_setzero_ps();
+	auto height1 = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		auto bytes = _mm_loadu_si128((const __m128i *)(text + i));
+		auto index0 = _mm256_cvtepu8_epi32(bytes);
+		auto index1 = _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8));
+		width0 = _mm256_add_ps(width0, _mm256_i32gather_ps(advances, index0, 4));
+		width1 = _mm256_add_ps(width1, _mm256_i32gather_ps(advances, index1, 4));
+		height0 = _mm256_max_ps(height0, _mm256_i32gather_ps(heights, index0, 4));
+		height1 = _mm256_max_ps(height1, _mm256_i32gather_ps(heights, index1, 4));
+	}
+
+	width += horizontal_add(_mm256_add_ps(width0, width1));
+	height = std::max(height, horizontal_max(_mm256_max_ps(height0, height1)));
+	return i;
+}
+#elif defined(NSC_MEASURE_SSE)
+float horizontal_add(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+float horizontal_max(__m128 v)
+{
+	v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+// SSE has no gather, so lanes are filled with scalar loads; the win is
+// four independent adds and maxes per step instead of one serial chain.
+size_t measure_simd(const float *advances, const float *heights, const unsigned char *text, size_t count,
+					float &width, float &height)
+{
+	auto width0 = _mm_setzero_ps();
+	auto width1 = _mm_setzero_ps();
+	auto height0 = _mm_setzero_ps();
+	auto height1 = _mm_setzero_ps();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		auto t = text + i;
+		width0 = _mm_add_ps(width0, _mm_setr_ps(advances[t[0]], advances[t[1]], advances[t[2]], advances[t[3]]));
+		width1 = _mm_add_ps(width1, _mm_setr_ps(advances[t[4]], advances[t[5]], advances[t[6]], advances[t[7]]));
+		height0 = _mm_max_ps(height0, _mm_setr_ps(heights[t[0]], heights[t[1]], heights[t[2]], heights[t[3]]));
+		height1 = _mm_max_ps(height1, _mm_setr_ps(heights[t[4]], heights[t[5]], heights[t[6]], heights[t[7]]));
+	}
+
+	width += horizontal_add(_mm_add_ps(width0, width1));
+	height = std::max(height, horizontal_max(_mm_max_ps(height0, height1)));
+	return i;
+}
+#endif
+}
+
+GlyphChoice choose_glyph(Font &font, uint32_t codepoint)
+{
+	GlyphChoice choice { &font.glyphs[codepoint], font.texture, false, false };
+	auto atlas = font.atlas.get();
+	// Control characters have never drawn anything; they are not worth a
+	// trip to the atlas.
+	if (!atlas || is_control(codepoint) || font.glyphs.contains(codepoint)) {
+		return choice;
+	}
+
+	if (auto generated = atlas->find(codepoint)) {
+		choice.glyph = generated;
+		choice.texture = atlas->get_texture();
+		choice.from_atlas = true;
+	} else {
+		choice.glyph = &font.glyphs['?'];
+		choice.placeholder = true;
+	}
+	return choice;
+}
+
+TextExtents measure_text(Font &font, size_t font_size, std::string_view msg)
+{
+	static_assert(GlyphTable::base_range >= 128, "every ASCII byte must index the flat tables");
+
+	auto advances = font.glyphs.advances();
+	auto heights = font.glyphs.heights();
+	auto text = (const unsigned char *)msg.data();
+
+	auto width = 0.f;
+	auto height = 0.f;
+	auto has_placeholders = false;
+	size_t i = 0;
+	while (i < msg.size()) {
+		auto run = table_run(font.glyphs, text + i, msg.size() - i);
+		if (run > 0) {
+			size_t done = 0;
+#if defined(NSC_MEASURE_AVX2) || defined(NSC_MEASURE_SSE)
+			// Between words of other scripts runs are often a lone space,
+			// too short to repay the horizontal sums.
+			if (run >= 16) {
+				done = measure_simd(advances, heights, text + i, run, width, height);
+			}
+#endif
+			measure_scalar(advances, heights, text + i + done, run - done, width, height);
+			i += run;
+			continue;
+		}
+
+		// Decodes up to the next ASCII byte, so text in other scripts does
+		// not look for a run after every codepoint.
+		do {
+			auto codepoint = nsc::utf8_next(msg, i);
+			auto choice = choose_glyph(font, codepoint);
+			auto glyph = choice.glyph;
+			width += glyph->advance;
+			if (codepoint != ' ' && glyph->plane_right > glyph->plane_left) {
+				height = std::max(height, glyph->plane_top - glyph->plane_bottom);
+			}
+			has_placeholders |= choice.placeholder;
+		} while (i < msg.size() && text[i] >= 0x80);
+	}
+
+	auto size = (float)font_size;
+	return TextExtents { width * size, height * size, has_placeholders };
+}
@@ -0,0 +1,43 @@
+#ifndef TEXT_MEASURE_HPP_
+#define TEXT_MEASURE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "font.hpp"
+
+struct TextExtents
+{
+	// Sum of the advances.
+	float width;
+	// Tallest glyph, ignoring spaces.
+	float height;
+	// Some glyphs were still being generated and were measured as '?'.
+	bool has_placeholders;
+};
+
+// The glyph text is drawn with for one codepoint.
+struct GlyphChoice
+{
+	const GlyphMetrics *glyph;
+	nsc::rendering::Texture *texture;
+	// The glyph is in the font's GlyphAtlas rather than its prebuilt texture.
+	bool from_atlas;
+	// The font's '?', standing in for a glyph the atlas is still generating.
+	bool placeholder;
+};
+
+// Picks the font's own glyph, then one from its GlyphAtlas, which it asks
+// for if need be, then '?'. Control characters get the font's all-zero
+// metrics.
+GlyphChoice choose_glyph(Font &font, uint32_t codepoint);
+
+// Measures UTF-8 msg as a single line of font at font_size pixels per em,
+// with the glyphs choose_glyph picks. Runs of ASCII the font's flat tables
+// cover are summed with AVX2 or SSE when the build targets them; anything
+// else is decoded and looked up a codepoint at a time. Define NSC_NO_SIMD
+// to force the scalar loop.
+TextExtents measure_text(Font &font, size_t font_size, std::string_view msg);
+
+#endif
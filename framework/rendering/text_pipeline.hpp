@@ -5,6 +5,7 @@
 #include <vector>
 #include "font.hpp"
 #include "descriptions.hpp"
+#include "glyph_batcher.hpp"
 #include "../core/registry.hpp"
 
 class TextPipeline
@@ -13,22 +14,17 @@ public:
 	TextPipeline();
 	~TextPipeline();
 
-	void render(nsc::registry *descs, const glm::mat4 &proj, const glm::mat4 &view);
-
-	void render(const std::vector<TextDesc> *descs,
-				const glm::mat4 &proj, const glm::mat4 &view);
-
-	void render(const std::vector<RichTextDesc> *descs,
-				const glm::mat4 &proj, const glm::mat4 &view);
+	void render(const nsc::registry *descs, const glm::mat4 &proj, const glm::mat4 &view);
 private:
-	void render_text_description(const TextDesc &desc);
-	void render_one_char(Font *font, int size, char c, float *x, float *y);
-
-	void render_centered(const TextDesc &desc);
-	void render_rich_text(const RichTextDesc &desc);
+	void upload_instances(const std::vector<GlyphInstance> &instances);
 
 	unsigned int VAO;
+	unsigned int quad_VBO;
+	unsigned int instance_VBO;
+	// In instances, not bytes.
+	size_t instance_capacity;
 	Shader shader;
+	GlyphBatcher batcher;
 };
 
 
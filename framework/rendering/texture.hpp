@@ -1,10 +1,13 @@
 #pragma once
 
+#include "../core/asset.hpp"
+
 namespace nsc::rendering {
 struct Texture {
     unsigned int texture;
     int width;
     int height;
     int num_channels;
+    nsc::asset_id id;
 };
 }
\ No newline at end of file
@@ -34,8 +34,10 @@ nsc::rendering::Texture * TextureCatalog::load_texture(const std::string &path,
 		glBindTexture(GL_TEXTURE_2D, 0);
 		stbi_image_free(data);
 
-		auto texture_obj = nsc::rendering::Texture { texture, width, height, num_channels };
+		auto id = nsc::make_asset_id(path);
+		auto texture_obj = nsc::rendering::Texture { texture, width, height, num_channels, id };
 		path_to_texture[path] = texture_obj;
+		id_to_source[id] = TextureSource { path, alpha };
 	}
 	return &path_to_texture[path];
 }
@@ -45,6 +47,31 @@ void TextureCatalog::release_texture(const std::string& path)
 	
 }
 
+nsc::rendering::Texture * TextureCatalog::find_texture(nsc::asset_id id)
+{
+	auto source = id_to_source.find(id);
+	if (source == id_to_source.end()) {
+		return nullptr;
+	}
+	return &path_to_texture[source->second.path];
+}
+
+void TextureCatalog::export_assets(nsc::asset_table &assets) const
+{
+	for (const auto &[id, source] : id_to_source) {
+		assets.add(id, nsc::asset_kind::texture, source.path, source.alpha ? 1 : 0);
+	}
+}
+
+void TextureCatalog::import_assets(const nsc::asset_table &assets)
+{
+	for (const auto &[id, entry] : assets.entries()) {
+		if (entry.kind == nsc::asset_kind::texture) {
+			load_texture(entry.path, entry.flags & 1);
+		}
+	}
+}
+
 ImageDesc TextureCatalog::create(const std::string& image_path, const nsc::rendering::Color& color, const nsc::ui::Rectangle& bounds)
 {
 	auto texture = load_texture(image_path);
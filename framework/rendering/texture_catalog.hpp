@@ -5,6 +5,7 @@
 #include <string>
 #include <utility>
 #include "texture.hpp"
+#include "../core/asset.hpp"
 #include "descriptions.hpp"
 #include "../ui/rectangle.hpp"
 
@@ -17,10 +18,24 @@ public:
 	nsc::rendering::Texture *load_texture(const std::string &path, bool alpha=false);
 	void release_texture(const std::string &path);
 
+	// Looks up a texture that was loaded earlier by its asset id.
+	nsc::rendering::Texture *find_texture(nsc::asset_id id);
+	// Lists every loaded texture, e.g. before saving a scene.
+	void export_assets(nsc::asset_table &assets) const;
+	// Loads every texture listed, e.g. before restoring a scene.
+	void import_assets(const nsc::asset_table &assets);
+
 	ImageDesc create(const std::string &image_path, const nsc::rendering::Color &color, const nsc::ui::Rectangle &bounds);
 	
 private:
+	struct TextureSource
+	{
+		std::string path;
+		bool alpha;
+	};
+
 	std::unordered_map<std::string, nsc::rendering::Texture> path_to_texture;
+	std::unordered_map<nsc::asset_id, TextureSource> id_to_source;
 };
 
 #endif
@@ -1,19 +1,162 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <memory_resource>
+#include <vector>
 
+#include "../core/coroutine.hpp"
 #include "../core/event_handler.hpp"
 #include "../core/registry.hpp"
 #include "rectangle.hpp"
 
 namespace nsc::ui {
+// Elements form a tree. Events sent with route_event() travel the DOM way: down
+// from the root through every ancestor's capture_handler, then to the
+// target's event_handler, then back up through every ancestor's
+// event_handler. Any callback along the way can call stop_propagation().
+//
+// Each element keeps its root-to-self path and only rebuilds it after the
+// tree has changed, so routing an event costs O(depth) and never allocates.
+// Bounds are in window coordinates, like those of a root element.
+//
+// Deleting an element from inside one of its own callbacks would free the
+// handler that is still calling it, and an App may still point at it; use
+// release() instead, which defers the delete.
 class Element {
    public:
-    Element(uint32_t id, const Rectangle &bounds) 
-        : bounds(bounds) {
+    Element(uint32_t id, const Rectangle &bounds,
+            std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : event_handler(resource), capture_handler(resource), bounds(bounds) {
         this->id = id;
     }
-    ~Element() {}
+    virtual ~Element() {
+        if (parent) {
+            parent->remove_child(this);
+        }
+        for (auto child : children) {
+            child->parent = nullptr;
+        }
+        ++tree_version;
+    }
+
+    Element(const Element &) = delete;
+    Element &operator=(const Element &) = delete;
+
+    // Reparents child if it already has a parent.
+    void add_child(Element *child) {
+        if (child->parent) {
+            child->parent->remove_child(child);
+        }
+        child->parent = this;
+        children.push_back(child);
+        ++tree_version;
+    }
+
+    void remove_child(Element *child) {
+        auto pos = std::find(children.begin(), children.end(), child);
+        if (pos == children.end()) {
+            return;
+        }
+        children.erase(pos);
+        child->parent = nullptr;
+        ++tree_version;
+    }
+
+    // Takes element out of its tree, which ends any route through it, and
+    // deletes it at the next delete_released(). Unlike delete, this is safe
+    // from inside element's own callbacks. element must have come from new.
+    static void release(Element *element) {
+        if (std::find(released.begin(), released.end(), element) != released.end()) {
+            return;
+        }
+        if (element->parent) {
+            element->parent->remove_child(element);
+        }
+        ++tree_version;
+        released.push_back(element);
+    }
+
+    static const std::vector<Element *> &get_released() { return released; }
+
+    // Not while an event is being dispatched; App calls this once per frame.
+    static void delete_released() {
+        auto doomed = std::move(released);
+        released.clear();
+        for (auto element : doomed) {
+            delete element;
+        }
+    }
+
+    Element *get_parent() const { return parent; }
+    const std::vector<Element *> &get_children() const { return children; }
+
+    // The deepest element under (x, y), or nullptr if it is outside this
+    // one. Later children are on top of earlier ones.
+    Element *hit_test(float x, float y) {
+        if (!bounds.is_inside(x, y)) {
+            return nullptr;
+        }
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            if (auto hit = (*it)->hit_test(x, y)) {
+                return hit;
+            }
+        }
+        return this;
+    }
+
+    // Calls f on this element and all of its descendants, parents first.
+    // f may add or release elements (visit indexes, so nothing dangles), but
+    // a child that moves past the current index is not visited this time.
+    template <typename F>
+    void visit(F &&f) {
+        f(*this);
+        for (std::size_t i = 0; i < children.size(); ++i) {
+            children[i]->visit(f);
+        }
+    }
+
+    // The path from the root of this element's tree down to this element.
+    const std::vector<Element *> &get_route() {
+        if (route_version != tree_version) {
+            route.clear();
+            for (auto e = this; e; e = e->parent) {
+                route.push_back(e);
+            }
+            std::reverse(route.begin(), route.end());
+            route_version = tree_version;
+        }
+        return route;
+    }
+
+    // Sends e through the capture, target and bubble phases described
+    // above, with this element as the target.
+    //
+    // A callback that changes any tree (e.g. releases the dialog it closes)
+    // ends the route there: the rest of the path, this element and the path
+    // itself included, may no longer exist, so nothing of it is touched
+    // again.
+    template <typename Event>
+    void route_event(const Event &e) {
+        auto version = tree_version;
+        auto &path = get_route();
+        auto depth = path.size();
+        auto outer_stopped = propagation_stopped;
+        propagation_stopped = false;
+
+        auto routing = [&] { return !propagation_stopped && tree_version == version; };
+        for (std::size_t i = 0; routing() && i + 1 < depth; ++i) {
+            path[i]->capture_handler.template publish<Event>(e);
+        }
+        for (std::size_t i = depth; routing() && i-- > 0;) {
+            path[i]->event_handler.template publish<Event>(e);
+        }
+        propagation_stopped = outer_stopped;
+    }
+
+    // Ends the route_event currently being dispatched after the current
+    // element's callbacks.
+    static void stop_propagation() { propagation_stopped = true; }
 
     template <typename Renderable, typename... Args>
     void add_renderable(Args ...args) {
@@ -27,16 +170,59 @@ class Element {
 
     template <typename Event>
     void unsubscribe_on(const nsc::event_handle handle) {
-        return event_handler.unsubscribe(handle);
+        return event_handler.unsubscribe<Event>(handle);
     }
 
     template <typename Event>
     void publish_on(const Event &e) {
-        return event_handler.publish(e);
+        return event_handler.publish<Event>(e);
+    }
+
+    // Subscribes to Events routed to this element's descendants, before
+    // they reach them.
+    template <typename Event, typename Connection>
+    nsc::event_handle subscribe_capture_on(Connection &&conn) {
+        return capture_handler.subscribe<Event>(std::move(conn));
+    }
+
+    template <typename Event>
+    void unsubscribe_capture_on(const nsc::event_handle handle) {
+        return capture_handler.unsubscribe<Event>(handle);
+    }
+
+    // Awaitable inside an nsc::task: co_await element.next<MouseClickEvent>()
+    // suspends until this element's next click and evaluates to it.
+    template <typename Event>
+    nsc::next_event<Event> next() {
+        return nsc::next_event<Event>(event_handler);
+    }
+
+    template <typename Event, typename Connection>
+    nsc::event_handle subscribe_batch_on(Connection &&conn) {
+        return event_handler.subscribe_batch<Event>(std::move(conn));
+    }
+
+    // See event_handler::make_queue.
+    template <typename Event>
+    nsc::event_queue<Event> *make_queue_on(std::size_t capacity) {
+        return event_handler.make_queue<Event>(capacity);
     }
 
     nsc::event_handler event_handler;
+    nsc::event_handler capture_handler;
     Rectangle bounds;
     uint32_t id;
+
+   private:
+    // Bumped on every change to any tree, which invalidates every cached
+    // route at once.
+    inline static uint64_t tree_version = 0;
+    inline static bool propagation_stopped = false;
+    inline static std::vector<Element *> released;
+
+    Element *parent = nullptr;
+    std::vector<Element *> children;
+    std::vector<Element *> route;
+    uint64_t route_version = ~uint64_t{0};
 };
 }
@@ -10,8 +10,6 @@ class Rectangle {
         : x(x), y(y), width(width), height(height) {
     }
 
-    ~Rectangle() {}
-
     bool is_inside(float x, float y) {
         return ((x >= this->x && x <= this->x + this->width) &&
                 (y >= this->y && y <= this->y + this->height));
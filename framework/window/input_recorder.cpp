@@ -0,0 +1,232 @@
+#include "input_recorder.hpp"
+
+#include <cstring>
+
+namespace {
+const char log_magic[4] = { 'N', 'S', 'C', 'I' };
+const uint32_t log_version = 1;
+const size_t flush_threshold = 64 * 1024;
+}
+
+InputRecorder::InputRecorder()
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+	close();
+}
+
+bool InputRecorder::open(const std::string &path)
+{
+	close();
+	out.open(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		return false;
+	}
+
+	buffer.reserve(flush_threshold + 64);
+	buffer.insert(buffer.end(), log_magic, log_magic + sizeof(log_magic));
+	write(log_version);
+	return true;
+}
+
+void InputRecorder::close()
+{
+	if (out.is_open()) {
+		flush();
+		out.close();
+	}
+}
+
+bool InputRecorder::is_open() { return out.is_open(); }
+
+template <typename T>
+void InputRecorder::write(const T &value)
+{
+	auto bytes = reinterpret_cast<const char *>(&value);
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+void InputRecorder::flush()
+{
+	out.write(buffer.data(), buffer.size());
+	buffer.clear();
+}
+
+void InputRecorder::record_frame(float delta_time)
+{
+	if (!out.is_open()) {
+		return;
+	}
+	if (buffer.size() >= flush_threshold) {
+		flush();
+	}
+	write(InputRecordType::FRAME);
+	write(delta_time);
+}
+
+void InputRecorder::record_cursor(float x, float y)
+{
+	write(InputRecordType::CURSOR);
+	write(x);
+	write(y);
+}
+
+void InputRecorder::record_mouse_click(int button, int action, int mods)
+{
+	write(InputRecordType::MOUSE_CLICK);
+	write((uint8_t)button);
+	write((uint8_t)action);
+	write((uint8_t)mods);
+}
+
+void InputRecorder::record_key(int key, int scancode, int action, int mods)
+{
+	write(InputRecordType::KEY);
+	write((int16_t)key);
+	write((int32_t)scancode);
+	write((uint8_t)action);
+	write((uint8_t)mods);
+}
+
+void InputRecorder::record_char_input(unsigned int codepoint)
+{
+	write(InputRecordType::CHAR_INPUT);
+	write((uint32_t)codepoint);
+}
+
+void InputRecorder::record_window_resize(int width, int height)
+{
+	write(InputRecordType::WINDOW_RESIZE);
+	write((int32_t)width);
+	write((int32_t)height);
+}
+
+InputReplayer::InputReplayer()
+	: cursor(0), done(true)
+{
+}
+
+InputReplayer::~InputReplayer()
+{
+}
+
+bool InputReplayer::open(const std::string &path)
+{
+	done = true;
+	cursor = 0;
+	if (!file.open(path)) {
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version;
+	if (!read(magic) || std::memcmp(magic, log_magic, sizeof(magic)) != 0 ||
+	    !read(version) || version != log_version) {
+		file.close();
+		return false;
+	}
+
+	done = false;
+	return true;
+}
+
+template <typename T>
+bool InputReplayer::read(T &value)
+{
+	if (file.size() - cursor < sizeof(T)) {
+		return false;
+	}
+	std::memcpy(&value, file.data() + cursor, sizeof(T));
+	cursor += sizeof(T);
+	return true;
+}
+
+bool InputReplayer::peek(InputRecordType &type)
+{
+	if (cursor >= file.size()) {
+		return false;
+	}
+	std::memcpy(&type, file.data() + cursor, sizeof(type));
+	return true;
+}
+
+bool InputReplayer::begin_frame(float &delta_time, float &cursor_x, float &cursor_y)
+{
+	// Skip whatever the caller did not consume from the previous frame.
+	InputEvent skipped;
+	while (next_event(skipped)) {
+	}
+
+	InputRecordType type;
+	if (done || !read(type) || type != InputRecordType::FRAME || !read(delta_time)) {
+		done = true;
+		return false;
+	}
+
+	if (peek(type) && type == InputRecordType::CURSOR) {
+		cursor += sizeof(type);
+		if (!read(cursor_x) || !read(cursor_y)) {
+			done = true;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool InputReplayer::next_event(InputEvent &event)
+{
+	InputRecordType type;
+	if (done || !peek(type) || type == InputRecordType::FRAME) {
+		return false;
+	}
+	cursor += sizeof(type);
+	event.type = type;
+
+	bool ok = false;
+	switch (type) {
+	case InputRecordType::MOUSE_CLICK: {
+		uint8_t button, action, mods;
+		ok = read(button) && read(action) && read(mods);
+		event.values[0] = button;
+		event.values[1] = action;
+		event.values[2] = mods;
+		break;
+	}
+	case InputRecordType::KEY: {
+		int16_t key;
+		int32_t scancode;
+		uint8_t action, mods;
+		ok = read(key) && read(scancode) && read(action) && read(mods);
+		event.values[0] = key;
+		event.values[1] = scancode;
+		event.values[2] = action;
+		event.values[3] = mods;
+		break;
+	}
+	case InputRecordType::CHAR_INPUT: {
+		uint32_t codepoint;
+		ok = read(codepoint);
+		event.values[0] = (int32_t)codepoint;
+		break;
+	}
+	case InputRecordType::WINDOW_RESIZE: {
+		int32_t width, height;
+		ok = read(width) && read(height);
+		event.values[0] = width;
+		event.values[1] = height;
+		break;
+	}
+	default:
+		// A stray cursor record or an unknown type: the log is corrupt.
+		break;
+	}
+
+	if (!ok) {
+		done = true;
+	}
+	return ok;
+}
+
+bool InputReplayer::finished() { return done; }
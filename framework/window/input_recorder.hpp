@@ -0,0 +1,94 @@
+#ifndef INPUT_RECORDER_HPP
+#define INPUT_RECORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../core/mapped_file.hpp"
+
+// Input logs let a session be recorded once and replayed on every build, so
+// performance numbers come from identical interactions.
+//
+// A log is a header followed by a stream of one-byte-tagged records. Each
+// frame starts with a Frame record holding that frame's delta time; every
+// record after it, up to the next Frame, belongs to that frame. Events are
+// not stamped with frame numbers individually, which keeps an idle frame
+// down to five bytes. Values are written in host byte order.
+enum class InputRecordType : uint8_t
+{
+	FRAME = 0,
+	CURSOR = 1,
+	MOUSE_CLICK = 2,
+	KEY = 3,
+	CHAR_INPUT = 4,
+	WINDOW_RESIZE = 5
+};
+
+struct InputEvent
+{
+	InputRecordType type;
+	// MOUSE_CLICK: button, action, mods
+	// KEY:         key, scancode, action, mods
+	// CHAR_INPUT:  codepoint
+	// WINDOW_RESIZE: width, height
+	int32_t values[4];
+};
+
+class InputRecorder
+{
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	bool open(const std::string &path);
+	void close();
+	bool is_open();
+
+	void record_frame(float delta_time);
+	void record_cursor(float x, float y);
+	void record_mouse_click(int button, int action, int mods);
+	void record_key(int key, int scancode, int action, int mods);
+	void record_char_input(unsigned int codepoint);
+	void record_window_resize(int width, int height);
+
+private:
+	template <typename T>
+	void write(const T &value);
+	void flush();
+
+	std::ofstream out;
+	std::vector<char> buffer;
+};
+
+class InputReplayer
+{
+public:
+	InputReplayer();
+	~InputReplayer();
+
+	// Returns false if the file is missing or not an input log.
+	bool open(const std::string &path);
+
+	// Moves to the next frame and reads its delta time and, if the cursor
+	// moved, its position. Returns false once the log is exhausted.
+	bool begin_frame(float &delta_time, float &cursor_x, float &cursor_y);
+
+	// Returns the current frame's events in recorded order, then false.
+	bool next_event(InputEvent &event);
+
+	bool finished();
+
+private:
+	template <typename T>
+	bool read(T &value);
+	bool peek(InputRecordType &type);
+
+	nsc::mapped_file file;
+	size_t cursor;
+	bool done;
+};
+
+#endif
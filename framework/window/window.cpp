@@ -48,36 +48,126 @@ Window::~Window()
 {
 }
 
+// While replaying, input from GLFW is dropped; replay_events supplies it.
 void Window::handle_mouse_click(int button, int action, int mods)
 {
+	if (!replayer) {
+		emit_mouse_click(button, action, mods);
+	}
+}
+
+void Window::handle_char_input(unsigned int codepoint)
+{
+	if (!replayer) {
+		emit_char_input(codepoint);
+	}
+}
+
+void Window::handle_key(int key, int scancode, int action, int mods)
+{
+	if (!replayer) {
+		emit_key(key, scancode, action, mods);
+	}
+}
+
+void Window::handle_window_resize(int width, int height)
+{
+	if (!replayer) {
+		emit_window_resize(width, height);
+	}
+}
+
+void Window::emit_mouse_click(int button, int action, int mods)
+{
+	if (recorder) {
+		recorder->record_mouse_click(button, action, mods);
+	}
 	if (mouse_click_callback) {
 		(*mouse_click_callback)(button, action, mods);
 	}
 }
 
-void Window::handle_char_input(unsigned int codepoint)
+void Window::emit_char_input(unsigned int codepoint)
 {
+	if (recorder) {
+		recorder->record_char_input(codepoint);
+	}
 	if (char_input_callback) {
 		(*char_input_callback)(codepoint);
 	}
 }
 
-void Window::handle_key(int key, int scancode, int action, int mods)
+void Window::emit_key(int key, int scancode, int action, int mods)
 {
+	if (recorder) {
+		recorder->record_key(key, scancode, action, mods);
+	}
 	if (key_callback) {
 		(*key_callback)(key, scancode, action, mods);
 	}
 }
 
-void Window::handle_window_resize(int width, int height)
+void Window::emit_window_resize(int width, int height)
 {
+	if (recorder) {
+		recorder->record_window_resize(width, height);
+	}
 	if (window_resize_callback) {
 		(*window_resize_callback)(width, height);
 	}
 }
 
+bool Window::record_input(const std::string &path)
+{
+	auto new_recorder = std::make_unique<InputRecorder>();
+	if (!new_recorder->open(path)) {
+		return false;
+	}
+	recorder = std::move(new_recorder);
+	// Forces the first frame to record the cursor.
+	recorded_cursor_x = -1.0f;
+	recorded_cursor_y = -1.0f;
+	return true;
+}
+
+bool Window::replay_input(const std::string &path)
+{
+	auto new_replayer = std::make_unique<InputReplayer>();
+	if (!new_replayer->open(path)) {
+		return false;
+	}
+	replayer = std::move(new_replayer);
+	return true;
+}
+
+void Window::replay_events()
+{
+	InputEvent event;
+	while (replayer->next_event(event)) {
+		switch (event.type) {
+		case InputRecordType::MOUSE_CLICK:
+			emit_mouse_click(event.values[0], event.values[1], event.values[2]);
+			break;
+		case InputRecordType::KEY:
+			emit_key(event.values[0], event.values[1], event.values[2], event.values[3]);
+			break;
+		case InputRecordType::CHAR_INPUT:
+			emit_char_input((unsigned int)event.values[0]);
+			break;
+		case InputRecordType::WINDOW_RESIZE:
+			emit_window_resize(event.values[0], event.values[1]);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
 void Window::close()
 {
+	if (recorder) {
+		recorder->close();
+	}
 	glfwTerminate();
 }
 
@@ -87,12 +177,27 @@ void Window::pre_update()
 	delta_time = curr_frame - last_frame;
 	last_frame = curr_frame;
 
-	double new_cursor_x, new_cursor_y;
-	glfwGetCursorPos(window, &new_cursor_x, &new_cursor_y);
-	new_cursor_y = (double)height - new_cursor_y;
+	if (replayer) {
+		// The cursor keeps its last recorded position unless this frame
+		// moved it.
+		replayer->begin_frame(delta_time, cursor_x, cursor_y);
+	} else {
+		double new_cursor_x, new_cursor_y;
+		glfwGetCursorPos(window, &new_cursor_x, &new_cursor_y);
+		new_cursor_y = (double)height - new_cursor_y;
+
+		cursor_x = (float)new_cursor_x;
+		cursor_y = (float)new_cursor_y;
+	}
 
-	cursor_x = (float)new_cursor_x;
-	cursor_y = (float)new_cursor_y;
+	if (recorder) {
+		recorder->record_frame(delta_time);
+		if (cursor_x != recorded_cursor_x || cursor_y != recorded_cursor_y) {
+			recorder->record_cursor(cursor_x, cursor_y);
+			recorded_cursor_x = cursor_x;
+			recorded_cursor_y = cursor_y;
+		}
+	}
 }
 
 void Window::update()
@@ -102,6 +207,11 @@ void Window::update()
 void Window::post_update()
 {
 	glfwPollEvents();
+	// Recorded events happened during this same poll, so they are replayed
+	// at the same point in the frame.
+	if (replayer) {
+		replay_events();
+	}
 	glfwSwapBuffers(window);
 }
 
@@ -133,4 +243,4 @@ int Window::get_height() { return height; }
 float Window::get_cursor_x() { return cursor_x; }
 float Window::get_cursor_y() { return cursor_y; }
 float Window::get_delta_time() { return delta_time; }
-bool Window::should_close() { return glfwWindowShouldClose(window); }
\ No newline at end of file
+bool Window::should_close() { return glfwWindowShouldClose(window) || (replayer && replayer->finished()); }
\ No newline at end of file
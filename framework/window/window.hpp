@@ -8,6 +8,8 @@
 #include <vector>
 #include <string>
 #include "../ui/events.hpp"
+#include "input_recorder.hpp"
+#include <memory>
 #include <optional>
 
 enum CursorType
@@ -37,6 +39,14 @@ public:
 	void register_key_callback(std::function<void(int, int, int, int)> callback);
 	void register_window_resize_callback(std::function<void(int, int)> callback);
 
+	// Writes every frame's delta time, cursor position and input events to
+	// an input log at path until the window closes.
+	bool record_input(const std::string &path);
+	// Drives the window from an input log instead of the user: real input is
+	// ignored, each frame gets the recorded delta time, cursor and events,
+	// and should_close() turns true when the log runs out.
+	bool replay_input(const std::string &path);
+
 	void set_cursor(CursorType type);
 	int get_width();
 	int get_height();
@@ -49,6 +59,12 @@ private:
 	void handle_key(int key, int scancode, int action, int mods);
 	void handle_window_resize(int width, int height);
 
+	void emit_mouse_click(int button, int action, int mods);
+	void emit_char_input(unsigned int codepoint);
+	void emit_key(int key, int scancode, int action, int mods);
+	void emit_window_resize(int width, int height);
+	void replay_events();
+
 	GLFWwindow *window;
 	GLFWcursor *hand_cursor;
 	GLFWcursor *text_cursor;
@@ -58,6 +74,10 @@ private:
 	std::optional<std::function<void(int, int, int, int)>> key_callback;
 	std::optional<std::function<void(int, int)>> window_resize_callback;
 
+	std::unique_ptr<InputRecorder> recorder;
+	std::unique_ptr<InputReplayer> replayer;
+	float recorded_cursor_x, recorded_cursor_y;
+
 	float delta_time, last_frame;
 	float cursor_x, cursor_y;
 	int width, height;
@@ -0,0 +1,21 @@
+#version 420 core
+in vec2 TexCoords;
+in vec4 GlyphColor;
+in float DistanceFactor;
+
+out vec4 FragColor;
+
+uniform sampler2D msdf;
+
+float median(float r, float g, float b)
+{
+	return max(min(r, g), min(max(r, g), b));
+}
+
+void main()
+{
+	vec3 msd = texture(msdf, TexCoords).rgb;
+	float screen_distance = DistanceFactor * (median(msd.r, msd.g, msd.b) - 0.5);
+	float opacity = clamp(screen_distance + 0.5, 0.0, 1.0);
+	FragColor = vec4(GlyphColor.rgb, GlyphColor.a * opacity);
+}
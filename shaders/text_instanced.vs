@@ -0,0 +1,22 @@
+#version 420 core
+// A unit quad corner plus one GlyphInstance per glyph (see glyph_batcher.hpp).
+layout (location = 0) in vec2 corner;
+layout (location = 2) in vec4 glyph_rect;
+layout (location = 3) in vec4 glyph_uv;
+layout (location = 4) in float glyph_distance_factor;
+layout (location = 5) in vec4 glyph_color;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+out vec2 TexCoords;
+out vec4 GlyphColor;
+out float DistanceFactor;
+
+void main()
+{
+	gl_Position = projection * view * vec4(glyph_rect.xy + corner * glyph_rect.zw, 0.0, 1.0);
+	TexCoords = mix(glyph_uv.xy, glyph_uv.zw, corner);
+	GlyphColor = glyph_color;
+	DistanceFactor = glyph_distance_factor;
+}